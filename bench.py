@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+from __future__ import print_function
+
+import os
+import os.path
+import tempfile
+import time
+import subprocess
+import argparse
+
+path2c4 = os.path.join("build", "default", "c4")
+
+
+def msg(*args, **kwargs):
+    print(">>>", *args, **kwargs)
+
+
+def wide_scope(n):
+    """A function whose body declares and uses n variables."""
+    lines = ["int main(void) {"]
+    lines += ["  int v{};".format(i) for i in range(n)]
+    lines += ["  v{} = v{};".format(i, n - 1 - i) for i in range(n)]
+    lines += ["  return v0;", "}"]
+    return "\n".join(lines) + "\n"
+
+
+def wide_struct(n):
+    """A struct with n members, each of them accessed through . and ->"""
+    lines = ["struct S {"]
+    lines += ["  int m{};".format(i) for i in range(n)]
+    lines += ["};", "int main(void) {", "  struct S s;", "  struct S *p;",
+              "  p = &s;"]
+    lines += ["  s.m{} = p->m{};".format(i, n - 1 - i) for i in range(n)]
+    lines += ["  return s.m0;", "}"]
+    return "\n".join(lines) + "\n"
+
+
+def long_expressions(n):
+    """A function with n statements mixing arithmetic, pointer and logical
+    operators"""
+    lines = ["int main(void) {", "  int a;", "  int b;", "  char c;",
+             "  int *p;", "  int *q;", "  p = &a;", "  q = p;"]
+    lines += ["  a = (a * b + c - -b < a) && !(p == q) || p - q < b - (p + 1 != q);"
+              for i in range(n)]
+    lines += ["  return a;", "}"]
+    return "\n".join(lines) + "\n"
+
+
+def many_functions(n):
+    """n function definitions with small bodies, each calling the previous
+    one"""
+    lines = ["struct P { int x; struct P *next; };", "int g;"]
+    for i in range(n):
+        lines += ["int f{}(struct P *p, int k) {{".format(i),
+                  "  int i;",
+                  "  i = k * 2 + p->x;",
+                  "  while (i < 10) { if (p->next == 0) break; p = p->next; i = i + 1; }"]
+        if i > 0:
+            lines += ["  i = i + f{}(p, i - 1);".format(i - 1)]
+        lines += ["  return i + g;", "}"]
+    lines += ["int main(void) {", "  struct P p;", "  p.x = 0;", "  p.next = 0;",
+              "  return f{}(&p, 1);".format(n - 1), "}"]
+    return "\n".join(lines) + "\n"
+
+
+benchmarks = [
+    ("scope", wide_scope),
+    ("struct", wide_struct),
+    ("expr", long_expressions),
+    ("function", many_functions),
+]
+
+
+def c4(filename, params):
+    """Runs c4 on filename and returns the wall clock time in seconds."""
+    args = [path2c4] + params + [filename]
+    start = time.time()
+    returncode = subprocess.call(args, stdout=subprocess.DEVNULL)
+    if returncode != 0:
+        msg("{} failed with exit code {}".format(filename, returncode))
+    return time.time() - start
+
+
+def run(sizes, params):
+    with tempfile.TemporaryDirectory() as tmpdir:
+        for name, generator in benchmarks:
+            for n in sizes:
+                filename = os.path.join(tmpdir, "{}_{}.c".format(name, n))
+                with open(filename, "w") as f:
+                    f.write(generator(n))
+                msg("{:8} {:7d} members: {:.3f}s".format(
+                    name, n, c4(filename, params)))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Benchmark cc2013's front end.")
+    parser.add_argument('--executable', dest='c4')
+    parser.add_argument('--sizes', dest='sizes', default="1000,4000,16000")
+    parser.add_argument('--mode', dest='mode', default="--parse")
+    # further options for c4, e.g. --flag=--parallel-sema
+    parser.add_argument('--flag', dest='flags', action='append', default=[])
+    args = parser.parse_args()
+    if (args.c4):
+        path2c4 = os.path.abspath(args.c4)
+    run([int(n) for n in args.sizes.split(",")], [args.mode] + args.flags)
@@ -5,12 +5,16 @@ from __future__ import print_function
 import os
 import os.path
 import glob
+import re
 import subprocess
 from subprocess import PIPE
 import argparse
 
 path2c4 = os.path.join("build", "default", "c4")
 timeout = -127
+# pass tests in directories using one of these options are compiled with
+# --optimize instead of it, the others use the options of their directory
+frontend_options = ("--parse", "--print-ast")
 
 
 def msg(*args, **kwargs):
@@ -32,6 +36,22 @@ def c4(filename, params):
             return (timeout, None, None)
 
 
+def failed_check(filename, output):
+    """Returns the first CHECK or CHECK-NOT comment of filename which the
+    output of c4 violates, or None. The output must match the regular
+    expression of each CHECK and none of the CHECK-NOT ones."""
+    text = output.decode("utf-8", "replace")
+    with open(filename) as f:
+        for line in f:
+            check = re.match(r"\s*// (CHECK|CHECK-NOT): (.*)$", line)
+            if not check:
+                continue
+            found = re.search(check.group(2), text, re.MULTILINE) is not None
+            if found != (check.group(1) == "CHECK"):
+                return line.strip()
+    return None
+
+
 def preamble():
     msg("F(ail)|T(imeout)|S(ignal)|(unexpected )P(ass)")
 
@@ -47,61 +67,81 @@ def run(testdir=None):
     msg("Running tests in {}".format(testdir))
     subdirs = next(os.walk(testdir))[1]
     for directory in subdirs:
+        # each line of the config is a set of options; all tests are run
+        # with every set
         try:
             with open(os.path.join(testdir, directory, "c4flags.config")) as cf:
-                options = [cf.read().strip()]
+                option_sets = [line.split() for line in cf.read().splitlines()
+                               if line.strip()]
         except IOError:
-            options = ["--parse"]
+            option_sets = [["--parse"]]
+        option_sets = option_sets or [[]]
+        pass_option_sets = []
+        for options in option_sets:
+            if any(o in frontend_options for o in options):
+                options = ["--optimize"] + [o for o in options
+                                            if o not in frontend_options]
+            pass_option_sets.append(options)
         counter = 0
-        msg("Entering {}, using options {}".format(directory, *options))
+        msg("Entering {}, using options {}".format(
+            directory, " | ".join(" ".join(o) for o in option_sets)))
         # all files ending with c in pass should pass
         pass_folder = os.path.join(testdir, directory, "pass")
         should_pass = os.path.join(pass_folder, "*.c")
         if os.path.isdir(pass_folder):
             for test_file in glob.iglob(should_pass):
-                test_count += 1
-                counter += 1
-                if "--tokenize" in options:
-                    newopts = options[:]
-                else:
-                    newopts = ["--optimize"]
-                o = c4(test_file, newopts)
-                if (o[0]) == 0:
-                    print(".", end="")
-                else:
-                    if o[0] == timeout:
-                        print("T", end="")
-                        timed_out_test.append((test_file, None))
-                    else:
+                for newopts in pass_option_sets:
+                    test_count += 1
+                    counter += 1
+                    test_name = test_file
+                    if len(pass_option_sets) > 1:
+                        test_name += " ({})".format(" ".join(newopts))
+                    o = c4(test_file, newopts)
+                    check = failed_check(test_file, o[1]) if o[0] == 0 else None
+                    if check:
                         print("F", end="")
-                        failed_tests_pass.append((test_file, o[2]))
-                if counter == 80:
-                    counter = 0
-                    print("\n", end="")
+                        failed_tests_pass.append(
+                            (test_name, "{} failed\n".format(check).encode()))
+                    elif (o[0]) == 0:
+                        print(".", end="")
+                    else:
+                        if o[0] == timeout:
+                            print("T", end="")
+                            timed_out_test.append((test_name, None))
+                        else:
+                            print("F", end="")
+                            failed_tests_pass.append((test_name, o[2]))
+                    if counter == 80:
+                        counter = 0
+                        print("\n", end="")
 
         # all files ending with c in fail should fail
         fail_folder = os.path.join(testdir, directory, "fail")
         should_fail = os.path.join(fail_folder, "*.c")
         if os.path.isdir(fail_folder):
             for test_file in glob.iglob(should_fail):
-                test_count += 1
-                counter += 1
-                o = c4(test_file, options)
-                if (o[0]) == 0:
-                    print("P", end="")
-                    failed_tests_fail.append((test_file, None))
-                else:
-                    if o[0] == 1:
-                        print(".", end="")
-                    elif o[0] == timeout:
-                        print("T", end="")
-                        timed_out_test.append((test_file, None))
+                for options in option_sets:
+                    test_count += 1
+                    counter += 1
+                    test_name = test_file
+                    if len(option_sets) > 1:
+                        test_name += " ({})".format(" ".join(options))
+                    o = c4(test_file, options)
+                    if (o[0]) == 0:
+                        print("P", end="")
+                        failed_tests_fail.append((test_name, None))
                     else:
-                        print("S", end="")
-                        failed_tests_fail.append((test_file, o[2]))
-                if counter == 80:
-                    counter = 0
-                    print("\n", end="")
+                        if o[0] == 1:
+                            print(".", end="")
+                        elif o[0] == timeout:
+                            print("T", end="")
+                            timed_out_test.append((test_name, None))
+                        else:
+                            print("S", end="")
+                            failed_tests_fail.append((test_name, o[2]))
+                    if counter == 80:
+                        counter = 0
+                        print("\n", end="")
 
         if (counter):
             print("\n")
@@ -6,13 +6,16 @@
 #include "../parser/statementNode.h"
 #include "../parser/expressionNode.h"
 #include "../parser/semantic.h"
+#include "../utils/diagnostic.h"
 #include "../utils/exception.h"
 #include "../utils/util.h"
 #include "../utils/debug.h"
+#include "llvm/Support/ToolOutputFile.h"   /* tool_output_file */
 
 #include <memory>
 #include <algorithm>
 #include <iterator>
+#include <string>
 #include <typeinfo> // only for debugging purpose
 
 #define EMIT_IR(X) void X::emitIR(Codegeneration::IRCreator* creator)
@@ -24,16 +27,107 @@
     llvm::BasicBlock* falseSuccessor\
     )
 
-void Codegeneration::genLLVMIR(const char* filename, Parsing::AstRoot root, bool optimize) {
+namespace {
+  /* The rvalue of expression, converted to type if both of them are
+   * arithmetic, as if it was assigned to an object of type */
+  llvm::Value* emitConverted(Codegeneration::IRCreator* creator,
+                             const Parsing::SubExpression & expression,
+                             const Parsing::SemanticDeclarationNode & type)
+  {
+    auto value = expression->emit_rvalue(creator);
+    if (Semantic::isArithmeticType(type) && Semantic::hasArithmeticType(expression)) {
+      return creator->convert(value, expression->getType(), type);
+    }
+    return value;
+  }
+
+  /* Emits the rvalues of the operands of a binary operator; arithmetic ones
+   * are converted to the type of the usual arithmetic conversions, which is
+   * returned, otherwise nullptr */
+  Parsing::SemanticDeclarationNode emitConvertedOperands(
+      Codegeneration::IRCreator* creator,
+      const Parsing::SubExpression & lhsExpression,
+      const Parsing::SubExpression & rhsExpression,
+      llvm::Value* & lhs, llvm::Value* & rhs)
+  {
+    if (   !Semantic::hasArithmeticType(lhsExpression)
+        || !Semantic::hasArithmeticType(rhsExpression)) {
+      lhs = lhsExpression->emit_rvalue(creator);
+      rhs = rhsExpression->emit_rvalue(creator);
+      return Parsing::SemanticDeclarationNode{};
+    }
+    auto common = Semantic::applyUsualConversions(lhsExpression->getType(),
+                                                  rhsExpression->getType()).first;
+    lhs = emitConverted(creator, lhsExpression, common);
+    rhs = emitConverted(creator, rhsExpression, common);
+    return common;
+  }
+
+  // the rvalue of an integer expression as an index of pointer arithmetic
+  llvm::Value* emitIndex(Codegeneration::IRCreator* creator,
+                         const Parsing::SubExpression & expression)
+  {
+    return creator->convertToIndex(expression->emit_rvalue(creator),
+                                   expression->getType());
+  }
+}
+
+void Codegeneration::genLLVMIR(const char* filename, Parsing::AstRoot root,
+                               const Options & options) {
+
+  Codegeneration::IRCreator Creator (root->pos().name, options);
+  root->emitIR(&Creator);
+  Creator.finishModule();
+  // the module is incomplete if finishModule reported an error
+  if (hasNewErrors()) {
+    return;
+  }
+  Creator.optimize(options);
 
+  // the file is only created now, and removed again unless it was written
+  // completely, so that a failed compilation leaves no output behind
   std::string errorStr;
-  llvm::raw_fd_ostream stream(filename, errorStr);
-  Codegeneration::IRCreator Creator (filename);
+  auto binary = options.emit == Emit::BITCODE || options.emit == Emit::OBJECT;
+  llvm::tool_output_file output(filename, errorStr,
+      binary ? llvm::sys::fs::F_Binary : llvm::sys::fs::F_None);
+  if (!errorStr.empty()) {
+    throw std::runtime_error(std::string("cannot open ") + filename + ": " + errorStr);
+  }
+  auto & stream = output.os();
+  switch (options.emit) {
+    case Emit::LLVM:
+      Creator.print(stream); /* M is a llvm::Module */
+      break;
+    case Emit::BITCODE:
+      Creator.writeBitcode(stream);
+      break;
+    case Emit::ASSEMBLY:
+      Creator.emitMachineCode(stream, llvm::TargetMachine::CGFT_AssemblyFile);
+      break;
+    case Emit::OBJECT:
+      Creator.emitMachineCode(stream, llvm::TargetMachine::CGFT_ObjectFile);
+      break;
+  }
+  output.keep();
+  if (options.printStatistics) {
+    Creator.printStatistics(llvm::errs());
+  }
+}
+
+int Codegeneration::runLLVMIR(const char* name, Parsing::AstRoot root,
+                              const Options & options,
+                              const std::vector<std::string> & arguments) {
+  Codegeneration::IRCreator Creator (name, options);
   root->emitIR(&Creator);
-  if (optimize) {
-    Creator.optimize();
+  Creator.finishModule();
+  if (hasNewErrors()) {
+    return 1;
+  }
+  Creator.optimize(options);
+  if (options.printStatistics) {
+    Creator.printStatistics(llvm::errs());
   }
-  Creator.print(stream); /* M is a llvm::Module */
+  return Creator.run(arguments);
 }
 
 EMIT_IR(Parsing::AstNode)
@@ -65,6 +159,11 @@ EMIT_IR(Parsing::Declaration)
       function_type_->associatedValue = function;
       return;
     }
+    if (creator->canPromote(declNode)) {
+      creator->declareVariable(declNode, variable,
+          this->declarator->hasName() ? this->declarator->getIdentifier() : "");
+      return;
+    }
     auto var = creator->allocateInCurrentFunction(variable);
     declNode->associatedValue = var;
     if (this->declarator->hasName()) {
@@ -109,7 +208,8 @@ EMIT_IR(Parsing::ExternalDeclaration)
       auto as_struct = std::static_pointer_cast<StructDeclaration>(declNode);
       if (this->declarator->hasName()) {
         auto name = this->declarator->getIdentifier();
-        GlobalVariable *GlobVar = creator->makeGlobVar(*as_struct->llvm_type);
+        GlobalVariable *GlobVar = creator->makeGlobVar(*as_struct->llvm_type,
+            declNode->internalLinkage);
         //TODO: what should we do with the global variable now?
         GlobVar->setName(name); // FIXME: we probably want a get name method
         this->getSemanticNode()->associatedValue = GlobVar;
@@ -137,12 +237,14 @@ EMIT_IR(Parsing::ExternalDeclaration)
     this->getSemanticNode()->associatedValue = creator->startFunction(
         static_cast<FunctionType*>(external_declaration_type),
         name,
-        false);
+        false,
+        type->internalLinkage);
     return;
   }
   
   // TODO: move global variable creato into creator method?
-  GlobalVariable *GlobVar = creator->makeGlobVar(external_declaration_type);
+  GlobalVariable *GlobVar = creator->makeGlobVar(external_declaration_type,
+      type->internalLinkage);
    //TODO: what should we do with the global variable now?
   GlobVar->setName(name); // FIXME: we probably want a get name method
   this->getSemanticNode()->associatedValue = GlobVar;
@@ -153,26 +255,38 @@ EMIT_IR(Parsing::FunctionDefinition)
   // TODO: make name a member of functiondefiniton or declaration
   auto name = this->declarator->getIdentifier();
   // lookup the type of the current function
-  auto semtree = Parsing::SemanticForest::filename2SemanticTree(this->pos().name);
+  auto semtree = Parsing::CompilationContext::current().semanticTree;
   auto function_type_ = std::static_pointer_cast<FunctionDeclaration>(
       semtree->lookUpType(name, this->pos())
   );
   llvm::Function* function;
   if (!function_type_->associatedValue) {
     auto function_type = static_cast<llvm::FunctionType*>(creator->semantic_type2llvm_type(function_type_));
-    function = creator->startFunction(function_type, name);
+    function = creator->startFunction(function_type, name, true,
+                                      function_type_->internalLinkage);
   } else {
      function = static_cast<llvm::Function*>(function_type_->associatedValue);
      creator->startAlreadyDefinedFunction(function, name);
   }
+  creator->describeFunction(function, this->pos());
   auto parameter_index = 0;
   std::for_each(function->arg_begin(), function->arg_end(),
       [&](decltype(function->arg_begin()) argument){
       auto param = function_type_->parameter()[parameter_index];
+      ++parameter_index;
+      if (param->type() == Semantic::Type::POINTER
+          && std::static_pointer_cast<PointerDeclaration>(param)->restrictQualified) {
+        creator->markNoAlias(argument);
+      }
+      if (creator->canPromote(param)) {
+        // the argument is the first definition of the parameter
+        creator->declareVariable(param, argument, "");
+        return;
+      }
       // 1. Allocate a stack slot
       auto ptr = creator->allocateInCurrentFunction(argument->getType());
       // 2. Store the argument value
-      creator->store(argument, ptr);
+      creator->store(argument, ptr, creator->accessTag(param));
       // 3. associate type with value
       param->associatedValue = ptr;
       if (param->type() == Semantic::Type::POINTER) {
@@ -181,7 +295,6 @@ EMIT_IR(Parsing::FunctionDefinition)
           pointee->associatedValue = ptr;
         }
       }
-      ++parameter_index;
       });
   function_type_->associatedValue = function;
   
@@ -191,10 +304,23 @@ EMIT_IR(Parsing::FunctionDefinition)
   llvm::verifyFunction(*function);
 }
 
+/*
+ * Statements after a return, break, continue or goto are only emitted if a
+ * label inside them can be reached by goto or by the enclosing switch.
+ * Declarations are always emitted, the variables may be used behind a label.
+ */
 EMIT_IR(Parsing::CompoundStatement)
 {
-  for (auto statement : this->subStatements) {
-    statement->emitIR(creator);
+  for (auto item : this->subStatements) {
+    if (!creator->isReachable()) {
+      auto statement = std::dynamic_pointer_cast<Parsing::Statement>(item);
+      if (statement && !statement->containsLabel()
+          && !statement->containsCaseLabel()) {
+        continue;
+      }
+    }
+    creator->setDebugLocation(item->pos());
+    item->emitIR(creator);
   }
 }
 
@@ -202,7 +328,7 @@ EMIT_IR(Parsing::ReturnStatement)
 {
   llvm::Value* value = nullptr;
   if (this->expression) 
-    value = expression->emit_rvalue(creator);
+    value = emitConverted(creator, expression, returnType);
   creator->makeReturn(value);
 }
 
@@ -225,7 +351,6 @@ EMIT_IR(Parsing::LabeledStatement) {
 
 EMIT_IR(Parsing::GotoStatement) {
 
-  auto dead = creator->makeBlock("deadGotoBlock", false);
   llvm::BasicBlock *labelBlock;
 
   if (creator->hasLabel(label)) { // label was defined somewhere
@@ -235,85 +360,167 @@ EMIT_IR(Parsing::GotoStatement) {
     creator->addLabel(labelBlock, label);
   }
 
-  creator->connect(labelBlock);
-  creator->setCurrentBasicBlock(dead);
+  creator->makeJump(labelBlock);
 }
 
 
 EMIT_IR(Parsing::ContinueStatement) {
-  auto dead = creator->makeBlock("deadContinueBlock", false);
   creator->makeContinue();
-  creator->setCurrentBasicBlock(dead);
 }
 
 EMIT_IR(Parsing::BreakStatement) {
-   auto dead = creator->makeBlock("deadBreakBlock", false);
   creator->makeBreak();
-  creator->setCurrentBasicBlock(dead);
 }
 
+/*
+ * Loops are emitted rotated, as LLVM's loop passes expect them: the guard
+ * tests the condition once before the loop, a dedicated preheader enters the
+ * body, and the latch at its bottom repeats the test. The latch is where
+ * continue jumps to, it also holds the step of a for loop. A condition with
+ * && or || is true in several blocks, so they all branch to one backedge
+ * block, which holds the only edge back to the body.
+ *
+ * The SSA construction needs to know when all predecessors of a block have
+ * been created, so the jump targets of break and continue are set before the
+ * body is emitted and restored afterwards for the enclosing loop.
+ */
 EMIT_IR(Parsing::IterationStatement) {
+  auto outerBreakPoint = creator->getCurrentBreakPoint();
+  auto outerContinuePoint = creator->getCurrentContinuePoint();
+  std::string name = (kind == WHILE) ? "while" : (kind == DOWHILE) ? "do" : "for";
 
-  if (kind == WHILE) {
-    auto headerBlock = creator->makeBlock("while_header");
+  // the guard is entered even if the loop is only reachable by a label
+  creator->sealBlock(creator->makeBlock(name + "_guard"));
+  auto preheaderBlock = creator->makeBlock(name + "_preheader", false);
+  auto bodyBlock = creator->makeBlock(name + "_body", false);
+  auto latchBlock = creator->makeBlock(name + "_latch", false);
+  auto endBlock = creator->makeBlock(name + "_end", false);
 
-    auto contentBlock = creator->makeBlock("while_content", false);
-    auto endBlock = creator->makeBlock("while_end", false);
-
-    creator->setCurrentBreakPoint(endBlock);
-    creator->setCurrentContinuePoint(contentBlock);
+  // a missing condition is always true
+  auto emitTest = [&](llvm::BasicBlock* loopBlock) {
+    if (expression) {
+      creator->setDebugLocation(expression->pos());
+      expression->emit_condition(creator, loopBlock, endBlock);
+    } else {
+      creator->connect(loopBlock);
+    }
+  };
 
-    expression->emit_condition(creator, contentBlock, endBlock);
+  if (init) {
+    creator->setDebugLocation(init->pos());
+    init->emit_rvalue(creator);
+  }
+  // the body of a do while loop runs at least once
+  if (kind == DOWHILE) {
+    creator->connect(preheaderBlock);
+  } else {
+    emitTest(preheaderBlock);
+  }
+  creator->sealBlock(preheaderBlock);
+  creator->setCurrentBasicBlock(preheaderBlock);
+  creator->connect(bodyBlock);
+  creator->setCurrentBasicBlock(bodyBlock);
 
-    creator->setCurrentBasicBlock(contentBlock);
+  creator->setCurrentBreakPoint(endBlock);
+  creator->setCurrentContinuePoint(latchBlock);
+  creator->setDebugLocation(statement->pos());
+  statement->emitIR(creator);
 
-    if (statement) { // TODO should always exist? 
-      statement->emitIR(creator);
+  creator->connect(latchBlock);
+  creator->sealBlock(latchBlock);
+  // without continue, a body which always leaves the loop skips the latch
+  if (creator->enterIfReachable(latchBlock)) {
+    if (step) {
+      creator->setDebugLocation(step->pos());
+      step->emit_rvalue(creator);
     }
+    auto backedgeBlock = creator->makeBlock(name + "_backedge", false);
+    emitTest(backedgeBlock);
+    creator->sealBlock(backedgeBlock);
+    if (creator->enterIfReachable(backedgeBlock)) {
+      creator->makeJump(bodyBlock);
+      creator->markLoop(backedgeBlock);
+    }
+  }
+  creator->sealBlock(bodyBlock);
+  creator->sealBlock(endBlock);
+  creator->enterIfReachable(endBlock);
 
-    creator->connect(headerBlock);
-    creator->setCurrentBasicBlock(endBlock);
-  } else { // do while
-
-    auto contentBlock = creator->makeBlock("do_content");
+  creator->setCurrentBreakPoint(outerBreakPoint);
+  creator->setCurrentContinuePoint(outerContinuePoint);
+}
 
-    if (statement) { // TODO should always exist? 
-      statement->emitIR(creator);
-    }
+/*
+ * The SwitchInst is created before the body, whose case labels add
+ * themselves to it. The cases become jump tables or balanced trees, as LLVM
+ * sees fit.
+ */
+EMIT_IR(Parsing::SwitchStatement)
+{
+  creator->sealBlock(creator->makeBlock("switch-header"));
+  auto value = expression->emit_rvalue(creator);
+  auto endBlock = creator->makeBlock("switch-end", false);
 
-    auto testBlock = creator->makeBlock("do_test");
-    auto endBlock = creator->makeBlock("do_end", false);
+  auto outerBreakPoint = creator->getCurrentBreakPoint();
+  auto outerSwitch = creator->getCurrentSwitch();
+  creator->setCurrentBreakPoint(endBlock);
+  creator->setCurrentSwitch(creator->makeSwitch(value, endBlock));
 
-    creator->setCurrentBreakPoint(endBlock);
-    creator->setCurrentContinuePoint(contentBlock);
+  // code before the first label is unreachable
+  if (statement->containsCaseLabel() || statement->containsLabel()) {
+    creator->setDebugLocation(statement->pos());
+    statement->emitIR(creator);
+  }
+  creator->connect(endBlock);
 
+  creator->setCurrentBreakPoint(outerBreakPoint);
+  creator->setCurrentSwitch(outerSwitch);
+  creator->sealBlock(endBlock);
+  creator->enterIfReachable(endBlock);
+}
 
-    creator->setCurrentBasicBlock(testBlock);
-    expression->emit_condition(creator, contentBlock, endBlock);
-    
-    creator->setCurrentBasicBlock(endBlock);
+/*
+ * The block of a label is entered from the switch and by falling through
+ * from the code before it
+ */
+EMIT_IR(Parsing::CaseStatement)
+{
+  auto switchInst = creator->getCurrentSwitch();
+  llvm::ConstantInt* value = nullptr;
+  if (expression) {
+    value = creator->makeCaseValue(switchInst, expression->constantValue());
   }
+  auto block = creator->makeBlock(expression ? "switch-case" : "switch-default");
+  creator->addSwitchLabel(switchInst, value, block);
+  creator->sealBlock(block);
+  creator->setDebugLocation(statement->pos());
+  statement->emitIR(creator);
 }
 
 EMIT_IR(Parsing::SelectionStatement)
 {
-  creator->makeBlock("if-header");
+  creator->sealBlock(creator->makeBlock("if-header"));
 
   auto consequenceBlock = creator->makeBlock("if-consequence", false);
   auto alternativeBlock = creator->makeBlock("if-alternative", false);
   auto endBlock = creator->makeBlock("if-end", false);
   this->expression->emit_condition(creator, consequenceBlock, alternativeBlock);
+  creator->sealBlock(consequenceBlock);
+  creator->sealBlock(alternativeBlock);
   creator->setCurrentBasicBlock(consequenceBlock);
+  creator->setDebugLocation(this->ifStatement->pos());
   this->ifStatement->emitIR(creator);
   creator->connect(nullptr, endBlock);
   if (this->elseStatement) {
     creator->setCurrentBasicBlock(alternativeBlock);
+    creator->setDebugLocation(this->elseStatement->pos());
     this->elseStatement->emitIR(creator);
     creator->connect(nullptr, endBlock);
   } else {
     creator->connect(alternativeBlock, endBlock);
   }
-  creator->setCurrentBasicBlock(endBlock);
+  creator->sealBlock(endBlock);
+  creator->enterIfReachable(endBlock);
 }
 
 //##############################################################################
@@ -327,11 +534,16 @@ EMIT_CONDITION(Parsing::Expression) {
 
 EMIT_CONDITION(Parsing::BinaryExpression)
 {
+  if (this->hasConstantValue()) {
+    Parsing::Expression::emit_condition(creator, trueSuccessor, falseSuccessor);
+    return;
+  }
   switch (op) {
     case PunctuatorType::LAND: 
       {
       llvm::BasicBlock* shortCircuitingBB = creator->getControlFlowBlock();
       lhs->emit_condition(creator, shortCircuitingBB, falseSuccessor);
+      creator->sealBlock(shortCircuitingBB);
       creator->setCurrentBasicBlock(shortCircuitingBB);
       rhs->emit_condition(creator, trueSuccessor, falseSuccessor);
       }
@@ -340,6 +552,7 @@ EMIT_CONDITION(Parsing::BinaryExpression)
       {
       auto shortCircuitingBB = creator->getControlFlowBlock();
       lhs->emit_condition(creator, trueSuccessor, shortCircuitingBB);
+      creator->sealBlock(shortCircuitingBB);
       creator->setCurrentBasicBlock(shortCircuitingBB);
       rhs->emit_condition(creator, trueSuccessor, falseSuccessor);
       }
@@ -352,6 +565,10 @@ EMIT_CONDITION(Parsing::BinaryExpression)
 
 EMIT_CONDITION(Parsing::UnaryExpression)
 {
+  if (this->hasConstantValue()) {
+    Parsing::Expression::emit_condition(creator, trueSuccessor, falseSuccessor);
+    return;
+  }
   if (op == PunctuatorType::NOT) {
     operand->emit_condition(creator, falseSuccessor, trueSuccessor);
   } else {
@@ -361,9 +578,15 @@ EMIT_CONDITION(Parsing::UnaryExpression)
 
 EMIT_CONDITION(Parsing::TernaryExpression)
 {
+  if (this->hasConstantValue()) {
+    Parsing::Expression::emit_condition(creator, trueSuccessor, falseSuccessor);
+    return;
+  }
         llvm::BasicBlock* trueBlock = creator->getControlFlowBlock();
         llvm::BasicBlock* falseBlock = creator->getControlFlowBlock();
         this->condition->emit_condition(creator, trueBlock, falseBlock);
+        creator->sealBlock(trueBlock);
+        creator->sealBlock(falseBlock);
         creator->setCurrentBasicBlock(trueBlock);
         this->lhs->emit_condition(creator, trueSuccessor, falseSuccessor);
         creator->setCurrentBasicBlock(falseBlock);
@@ -419,6 +642,11 @@ EMIT_LV(Parsing::Expression) {
  * on the operand
  */
 EMIT_RV(Parsing::BinaryExpression) {
+  // constant expressions were already folded by the semantic analysis
+  if (this->hasConstantValue()) {
+    return creator->convert(creator->allocInt(this->constantValue()),
+                            this->getType());
+  }
   //First compute the values for the subexpressions
   // Not every operator requires lvalues! And the emit methods have side
   // effects, so they mustn't be called when the value is not required
@@ -432,88 +660,135 @@ EMIT_RV(Parsing::BinaryExpression) {
   //correct method to call
   switch(this->op){
 	case PunctuatorType::PLUS:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
-          if(this->lhs->getType()->type() == Semantic::Type::POINTER)
+          if(this->lhs->getType()->type() == Semantic::Type::POINTER) {
+            lhs = this->lhs->emit_rvalue(creator);
+            rhs = emitIndex(creator, this->rhs);
             return creator->createPAdd(lhs,rhs);
-          else if (this->rhs->getType()->type() == Semantic::Type::POINTER)
+          } else if (this->rhs->getType()->type() == Semantic::Type::POINTER) {
+            lhs = emitIndex(creator, this->lhs);
+            rhs = this->rhs->emit_rvalue(creator);
             return creator->createPAdd(rhs,lhs);
-          else 
-            return creator->createAdd(lhs, rhs);
+          }
+          emitConvertedOperands(creator, this->lhs, this->rhs, lhs, rhs);
+          return creator->createAdd(lhs, rhs);
 	case PunctuatorType::MINUS:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
           if(this->lhs->getType()->type() == Semantic::Type::POINTER){
+            lhs = this->lhs->emit_rvalue(creator);
             if (this->rhs->getType()->type() == Semantic::Type::POINTER){
+            rhs = this->rhs->emit_rvalue(creator);
             return creator->createPPMinus(lhs, rhs);
             }
+            rhs = emitIndex(creator, this->rhs);
             return creator->createPMinus(lhs,rhs);
           }
-          else 
-           return creator->createMinus(lhs, rhs);
-	case PunctuatorType::LESS:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
-          return creator->createLess(lhs, rhs);
+          emitConvertedOperands(creator, this->lhs, this->rhs, lhs, rhs);
+          return creator->createMinus(lhs, rhs);
+	case PunctuatorType::LESS: {
+          auto common = emitConvertedOperands(creator, this->lhs, this->rhs,
+                                              lhs, rhs);
+          return creator->createLess(lhs, rhs,
+              common && Semantic::isUnsignedType(common));
+                                   }
 	case PunctuatorType::STAR:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
+          emitConvertedOperands(creator, this->lhs, this->rhs, lhs, rhs);
           return creator->createMult(lhs, rhs);
 	case PunctuatorType::NEQUAL:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
+          emitConvertedOperands(creator, this->lhs, this->rhs, lhs, rhs);
           return creator->createUnequal(lhs, rhs);
 	case PunctuatorType::EQUAL:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
+          emitConvertedOperands(creator, this->lhs, this->rhs, lhs, rhs);
           return creator->createEqual(lhs, rhs);
 	case PunctuatorType::LAND:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
-          return creator->createLogAnd(lhs,rhs);
-        case PunctuatorType::LOR:
-          lhs = this->lhs->emit_rvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
-          return creator->createLogOr(lhs, rhs);
+        case PunctuatorType::LOR: {
+          // the right operand is only evaluated if the left one does not
+          // decide the result, so the int 0 or 1 is merged from both blocks
+          auto trueBlock = creator->makeBlock("logical-true", false);
+          auto falseBlock = creator->makeBlock("logical-false", false);
+          auto endBlock = creator->makeBlock("logical-end", false);
+          this->emit_condition(creator, trueBlock, falseBlock);
+          creator->sealBlock(trueBlock);
+          creator->sealBlock(falseBlock);
+          creator->setCurrentBasicBlock(trueBlock);
+          trueBlock = creator->connect(nullptr, endBlock);
+          creator->setCurrentBasicBlock(falseBlock);
+          falseBlock = creator->connect(nullptr, endBlock);
+          creator->sealBlock(endBlock);
+          creator->setCurrentBasicBlock(endBlock);
+          return creator->makePhi(trueBlock, creator->allocInt(1),
+                                  falseBlock, creator->allocInt(0));
+                                          }
         case PunctuatorType::ARRAY_ACCESS:
           if (Semantic::hasIntegerType(this->rhs)) {
             lhs = this->lhs->emit_rvalue(creator);
-            rhs = this->rhs->emit_rvalue(creator);
-            return creator->createArrayAccess(lhs, rhs);
+            rhs = emitIndex(creator, this->rhs);
           } else {
             // swapped array access:
             // 4[intpr];
-            lhs = this->rhs->emit_lvalue(creator);
-            rhs = this->lhs->emit_rvalue(creator);
-            return creator->createArrayAccess(lhs, rhs);
+            lhs = this->rhs->emit_rvalue(creator);
+            rhs = emitIndex(creator, this->lhs);
           }
+          return creator->tagAccess(creator->createArrayAccess(lhs, rhs),
+                                    this->accessTag(creator));
         case PunctuatorType::MEMBER_ACCESS:
 	case PunctuatorType::ARROW:
           {
-            //We need to find the correct index inside the struct
-            //First get the struct type
-            int index = creator->computeIndex(this->lhs, this->rhs);
+            //the index of the member inside the struct was computed
+            //during the semantic analysis
+            int index = this->memberIndex;
             if(this->op == PunctuatorType::ARROW) {
               //create the acces with the  correct index
               lhs = this->lhs->emit_rvalue(creator);
-              return creator->createPointerAccess(lhs, rhs, index);
+              return creator->tagAccess(
+                  creator->createPointerAccess(lhs, rhs, index),
+                  this->accessTag(creator));
             }
             else {
               lhs = this->lhs->emit_lvalue(creator);
-              return creator->createAccess(lhs, rhs, index);
+              return creator->tagAccess(creator->createAccess(lhs, rhs, index),
+                                        this->accessTag(creator));
             }
           }
 	case PunctuatorType::ASSIGN:{
-          lhs = this->lhs->emit_lvalue(creator);
-          rhs = this->rhs->emit_rvalue(creator);
           llvm::Type* type = creator->semantic_type2llvm_type(this->lhs->getType());
-          return creator->createAssign(lhs,rhs, type);
+          if (creator->isSSAVariable(this->lhs->getType())) {
+            // only a variable has the declaration of a variable as its type
+            rhs = emitConverted(creator, this->rhs, this->lhs->getType());
+            return creator->assignVariable(this->lhs->getType(), rhs, type);
+          }
+          lhs = this->lhs->emit_lvalue(creator);
+          rhs = emitConverted(creator, this->rhs, this->lhs->getType());
+          return creator->createAssign(lhs,rhs, type,
+                                       this->lhs->accessTag(creator));
                                     }
 	default:
 	  throw CompilerException("INTERNAL ERROR", this->pos());
 	}
 }
 
+llvm::MDNode* Parsing::Expression::accessTag(Codegeneration::IRCreator* creator)
+{
+  return creator->accessTag(this->getType());
+}
+
+/*
+ * Struct members are tagged with their struct, so that stores to one member
+ * do not clobber loads of another one
+ */
+llvm::MDNode* Parsing::BinaryExpression::accessTag(
+    Codegeneration::IRCreator* creator)
+{
+  switch (op) {
+    case PunctuatorType::MEMBER_ACCESS:
+      return creator->memberAccessTag(lhs->getType(), memberIndex);
+    case PunctuatorType::ARROW:
+      return creator->memberAccessTag(
+          std::static_pointer_cast<PointerDeclaration>(lhs->getType())->pointee(),
+          memberIndex);
+    default:
+      return Parsing::Expression::accessTag(creator);
+  }
+}
+
 EMIT_LV(Parsing::BinaryExpression){
         llvm::Value* lhs = nullptr;
         llvm::Value* rhs = nullptr;
@@ -521,7 +796,7 @@ EMIT_LV(Parsing::BinaryExpression){
         switch (this->op){
         case PunctuatorType::ARROW:
         case PunctuatorType::MEMBER_ACCESS: {
-                int index = creator->computeIndex(this->lhs, this->rhs);
+                int index = this->memberIndex;
                 if(this->op == PunctuatorType::ARROW) {
                   lhs = this->lhs->emit_rvalue(creator);
                   return creator->getAddressfromPointer(lhs,rhs,index);
@@ -530,8 +805,14 @@ EMIT_LV(Parsing::BinaryExpression){
                return creator->getMemberAddress(lhs,rhs, index);
                                             }
         case PunctuatorType::ARRAY_ACCESS:
-               lhs = this->lhs->emit_lvalue(creator);
-               rhs = this->rhs->emit_rvalue(creator);
+               if (Semantic::hasIntegerType(this->rhs)) {
+                 lhs = this->lhs->emit_rvalue(creator);
+                 rhs = emitIndex(creator, this->rhs);
+               } else {
+                 // swapped array access, see emit_rvalue
+                 lhs = this->rhs->emit_rvalue(creator);
+                 rhs = emitIndex(creator, this->lhs);
+               }
                return creator->getArrayPosition(lhs,rhs, 0);
         default:
                throw CompilerException("INTERNAL ERROR", this->pos());
@@ -542,6 +823,10 @@ EMIT_LV(Parsing::BinaryExpression){
  * computed, then the operator is applied.
  */
 EMIT_RV(Parsing::UnaryExpression) {
+  if (this->hasConstantValue()) {
+    return creator->convert(creator->allocInt(this->constantValue()),
+                            this->getType());
+  }
   llvm::Value* vl =  nullptr;
   switch(this->op){
     case PunctuatorType::NOT:
@@ -563,7 +848,8 @@ EMIT_RV(Parsing::UnaryExpression) {
         // pointer to the function; therefore, nothing happens
         return vl;
       }
-      return creator->createDeref(vl);
+      return creator->tagAccess(creator->createDeref(vl),
+                                this->accessTag(creator));
     case PunctuatorType::AMPERSAND:
       if (auto as_unary = std::dynamic_pointer_cast<UnaryExpression>(operand)) {
         if (as_unary->op == PunctuatorType::STAR) {
@@ -574,7 +860,7 @@ EMIT_RV(Parsing::UnaryExpression) {
       return this->operand->emit_lvalue(creator);
     case PunctuatorType::SIZEOF:
       if (auto as_array = std::dynamic_pointer_cast<Parsing::ArrayDeclaration>(this->operand->getType())) {
-        return creator->allocInt(as_array->size);
+        return creator->allocLong(as_array->size);
       }
       return creator->createSizeof(creator->semantic_type2llvm_type(operand->getType()));
     default:
@@ -609,12 +895,16 @@ EMIT_LV(Parsing::UnaryExpression) {
  * gave it so that we can do computations with it
  */
 EMIT_RV(Parsing::VariableUsage) {
+  if (creator->isSSAVariable(this->getType())) {
+    return creator->readVariable(this->getType());
+  }
   auto address = this->emit_lvalue(creator);
   if (this->getType()->type() == Semantic::Type::FUNCTION) {
     // function gets implicitly converted into function pointer
     return address;
   }
-  return creator->loadVariable(address);
+  return creator->tagAccess(creator->loadVariable(address),
+                            this->accessTag(creator));
 }
 
 /*
@@ -659,15 +949,17 @@ EMIT_RV(Parsing::Constant) {
         return creator->allocChar(val);
       }
     case Lexing::ConstantType::INT:
-      {
-        int val;
+      if (this->getType()->type() == Semantic::Type::LONG) {
+        // the semantic analysis made constants beyond int a long
+        long long val;
         try {
-          val = std::stoi(this->name);
+          val = std::stoll(this->name);
         } catch (std::out_of_range & e)  {
-          throw CompilerException("Integer constant value outside of range of int!", pos());
+          throw CompilerException("Integer constant value outside of range of long!", pos());
         }
-        return creator->allocInt(val);
+        return creator->allocLong(val);
       }
+      return creator->allocInt(std::stoi(this->name));
     case Lexing::ConstantType::NULLPOINTER:
       {
         //FIXME : we might need to set the type of the constant in the constructor of
@@ -688,22 +980,29 @@ EMIT_RV(Parsing::FunctionCall) {
  llvm::Value* func = nullptr;
  std::vector<llvm::Value*> values = std::vector<llvm::Value*> ();
   std::vector<llvm::Type*> types;
-  for(auto it = this->arguments.begin() ; it != this->arguments.end(); ++it){
-        values.push_back((*it)->emit_rvalue(creator));
-  }
   SemanticDeclarationNode function_type = this->funcName->getType();
-  if (function_type->type() == Semantic::Type::POINTER) {
+  auto isPointer = function_type->type() == Semantic::Type::POINTER;
+  if (isPointer) {
     // function pointer can be called
     function_type
       = std::static_pointer_cast<PointerDeclaration>(function_type)->pointee();
-    func = this->funcName->emit_rvalue(creator);
-  } else {
-    func = this->funcName->emit_lvalue(creator);
   }
   //The type must be an instance of a function type, otherwise semantics would 
   //have failed, so it is safe to cast here
   auto funcType = std::static_pointer_cast<Parsing::FunctionDeclaration>(function_type);
-  for (auto  p: funcType->parameter()) {
+  auto parameters = funcType->parameter();
+  // the arguments are converted as if they were assigned to the parameters
+  for (size_t i = 0; i < this->arguments.size(); ++i) {
+        values.push_back(i < parameters.size()
+            ? emitConverted(creator, this->arguments[i], parameters[i])
+            : this->arguments[i]->emit_rvalue(creator));
+  }
+  if (isPointer) {
+    func = this->funcName->emit_rvalue(creator);
+  } else {
+    func = this->funcName->emit_lvalue(creator);
+  }
+  for (auto  p: parameters) {
     types.push_back(creator->semantic_type2llvm_type(p));
   }
   llvm::Value* val = creator->createFCall(func, values, types);
@@ -712,26 +1011,149 @@ EMIT_RV(Parsing::FunctionCall) {
   return val;
 }
 
+//##############################################################################
+//#                    Speculation                                             #
+//##############################################################################
+
+namespace {
+  // an arm of ?: is evaluated unconditionally if it costs at most this many
+  // instructions, the same limit SimplifyCFG uses to fold a phi into a select
+  const int SPECULATION_LIMIT = 2;
+
+  // the cost of an operation on operands of the given costs
+  int operationCost(int lhsCost, int rhsCost = 0)
+  {
+    if (lhsCost < 0 || rhsCost < 0) {
+      return -1;
+    }
+    return lhsCost + rhsCost + 1;
+  }
+}
+
+int Parsing::BinaryExpression::speculationCost()
+{
+  if (this->hasConstantValue()) {
+    return 0;
+  }
+  switch (op) {
+    case PunctuatorType::PLUS:
+    case PunctuatorType::MINUS:
+    case PunctuatorType::STAR:
+    case PunctuatorType::LESS:
+    case PunctuatorType::EQUAL:
+    case PunctuatorType::NEQUAL:
+      return operationCost(lhs->speculationCost(), rhs->speculationCost());
+    default:
+      // assignments, short circuiting and memory accesses through pointers
+      return -1;
+  }
+}
+
+int Parsing::UnaryExpression::speculationCost()
+{
+  if (this->hasConstantValue()) {
+    return 0;
+  }
+  switch (op) {
+    case PunctuatorType::NOT:
+    case PunctuatorType::MINUS:
+      return operationCost(operand->speculationCost());
+    case PunctuatorType::AMPERSAND:
+      // the address of a variable is known without any instruction
+      return std::dynamic_pointer_cast<VariableUsage>(operand) ? 0 : -1;
+    default:
+      return -1;
+  }
+}
+
+int Parsing::VariableUsage::speculationCost()
+{
+  // at most a load from a stack slot or a global, which cannot trap
+  return 1;
+}
+
+int Parsing::Literal::speculationCost()
+{
+  return 0;
+}
+
+int Parsing::Constant::speculationCost()
+{
+  return 0;
+}
+
+int Parsing::SizeOfExpression::speculationCost()
+{
+  return 0;
+}
+
+int Parsing::TernaryExpression::speculationCost()
+{
+  if (this->hasConstantValue()) {
+    return 0;
+  }
+  if (!lowersToSelect()) {
+    return -1;
+  }
+  return operationCost(condition->speculationCost(),
+      operationCost(lhs->speculationCost(), rhs->speculationCost()));
+}
+
+bool Parsing::TernaryExpression::lowersToSelect()
+{
+  if (this->getType()->type() == Semantic::Type::VOID) {
+    return false;
+  }
+  // the select path emits the condition as an rvalue, which is only right
+  // for conditions without short circuiting and side effects
+  if (condition->speculationCost() < 0) {
+    return false;
+  }
+  auto lhsCost = lhs->speculationCost();
+  auto rhsCost = rhs->speculationCost();
+  return lhsCost >= 0 && lhsCost <= SPECULATION_LIMIT
+    && rhsCost >= 0 && rhsCost <= SPECULATION_LIMIT;
+}
+
 /*
  * A ternary operator can produce a valid rvalue. First evaluate the condition.
- * Then return the value based on the condition.
+ * Then return the value based on the condition. If both arms are cheap and
+ * free of side effects, they are both evaluated and the condition selects
+ * one of them, which saves the branches.
  */
 EMIT_RV(Parsing::TernaryExpression) {
+  if (this->hasConstantValue()) {
+    return creator->convert(creator->allocInt(this->constantValue()),
+                            this->getType());
+  }
   auto result_type = this->getType();
+  if (lowersToSelect()) {
+    auto condition = this->condition->emit_rvalue(creator);
+    auto val_consequence = creator->convert(
+        this->lhs->emit_rvalue(creator), this->lhs->getType(), result_type);
+    auto val_alternative = creator->convert(
+        this->rhs->emit_rvalue(creator), this->rhs->getType(), result_type);
+    return creator->makeSelect(condition, val_consequence, val_alternative);
+  }
   auto consequenceBlock = creator->makeBlock("ternary-consequence", false);
   auto alternativeBlock = creator->makeBlock("ternary-alternative", false);
   auto endBlock = creator->makeBlock("ternary-end", false);
   this->condition->emit_condition(creator, consequenceBlock, alternativeBlock);
+  creator->sealBlock(consequenceBlock);
+  creator->sealBlock(alternativeBlock);
   creator->setCurrentBasicBlock(consequenceBlock);
   auto val_consequence = this->lhs->emit_rvalue(creator);
   if (result_type->type() != Semantic::Type::VOID)
-    val_consequence = creator->convert(val_consequence, result_type);
+    val_consequence = creator->convert(val_consequence, this->lhs->getType(),
+                                       result_type);
   consequenceBlock = creator->connect(nullptr, endBlock);
   creator->setCurrentBasicBlock(alternativeBlock);
   auto val_alternative = this->rhs->emit_rvalue(creator);
   if (result_type->type() != Semantic::Type::VOID)
-    val_alternative = creator->convert(val_alternative, result_type);
+    val_alternative = creator->convert(val_alternative, this->rhs->getType(),
+                                       result_type);
   alternativeBlock = creator->connect(nullptr, endBlock);
+  creator->sealBlock(endBlock);
   creator->setCurrentBasicBlock(endBlock);
   if (this->getType()->type() == Semantic::Type::VOID) {
     // it should be safe to return nullptr, as the semantic ensures that nobody
@@ -749,6 +1171,8 @@ EMIT_LV(Parsing::TernaryExpression){
   auto alternativeBlock = creator->makeBlock("ternary-alternative", false);
   auto endBlock = creator->makeBlock("ternary-end", false);
   this->condition->emit_condition(creator, consequenceBlock, alternativeBlock);
+  creator->sealBlock(consequenceBlock);
+  creator->sealBlock(alternativeBlock);
   creator->setCurrentBasicBlock(consequenceBlock);
   auto val_consequence = this->lhs->emit_lvalue(creator);
   if (result_type->type() != Semantic::Type::VOID)
@@ -759,6 +1183,7 @@ EMIT_LV(Parsing::TernaryExpression){
   if (result_type->type() != Semantic::Type::VOID)
     val_alternative = creator->convert(val_alternative, result_type);
   alternativeBlock = creator->connect(nullptr, endBlock);
+  creator->sealBlock(endBlock);
   creator->setCurrentBasicBlock(endBlock);
   if (this->getType()->type() == Semantic::Type::VOID) {
     // it should be safe to return nullptr, as the semantic ensures that nobody
@@ -774,5 +1199,9 @@ EMIT_LV(Parsing::TernaryExpression){
  * Produces the rvalue of the sizeof expression. TODO!
  */
 EMIT_RV(Parsing::SizeOfExpression) {
+  if (this->hasConstantValue()) {
+    return creator->convert(creator->allocInt(this->constantValue()),
+                            this->getType());
+  }
   return creator->createSizeof(creator->semantic_type2llvm_type(this->sem_type));
 }
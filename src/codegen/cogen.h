@@ -1,6 +1,8 @@
 #ifndef COGEN_H
 #define COGEN_H
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace Parsing {
   class AstNode;
@@ -10,7 +12,54 @@ namespace Parsing {
 }
 
 namespace Codegeneration {
-  void genLLVMIR(const char* filename, Parsing::AstRoot root, bool optimize=false);
+  // what genLLVMIR writes to its output file
+  enum class Emit {
+    LLVM,      // textual LLVM IR
+    BITCODE,   // LLVM bitcode
+    ASSEMBLY,  // assembly for the host
+    OBJECT,    // object file for the host
+  };
+
+  enum class OptLevel {
+    O0,        // no optimization
+    O1,
+    O2,
+    O3,
+    SCCP,      // mem2reg and our SCCP_Pass only, selected by --optimize
+  };
+
+  struct Options {
+    OptLevel optLevel = OptLevel::O0;
+    bool printStatistics = false;
+    Emit emit = Emit::LLVM;
+    // more than one optimizes the functions in parallel partitions
+    unsigned optimizationWorkers = 0;
+    // annotates loads and stores with type based alias analysis metadata
+    bool typeBasedAliasAnalysis = true;
+    // counts the edges of the conditional branches; the program appends the
+    // counts to profileOutput when it exits, remove the file to start anew
+    bool instrument = false;
+    std::string profileOutput = "c4.profile";
+    // if not empty, weights the branches with the counts of this profile
+    std::string profileInput;
+    // emits line tables, also for optimized code
+    bool debugInfo = false;
+    // loop hints, attached to every loop as llvm.loop metadata; an unroll
+    // count of 0 leaves the choice to the optimizer
+    unsigned unrollCount = 0;
+    bool vectorize = false;
+  };
+
+  /* filename "-" writes to stdout; no file is left behind if compilation
+   * fails */
+  void genLLVMIR(const char* filename, Parsing::AstRoot root,
+                 const Options & options);
+
+  /* Compiles root with the JIT of the host and calls its main function with
+   * arguments as argv; returns the exit code of main */
+  int runLLVMIR(const char* name, Parsing::AstRoot root,
+                const Options & options,
+                const std::vector<std::string> & arguments);
 }
 
 #endif
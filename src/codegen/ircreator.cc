@@ -1,18 +1,30 @@
 #include "ircreator.h"
-#include "sccp_pass.h"
+#include "pipeline.h"
 
 #include "llvm/IR/Module.h"                /* Module */
+#include "llvm/IR/DataLayout.h"            /* DataLayout */
 #include "llvm/IR/Function.h"              /* Function */
 #include "llvm/IR/Constant.h"              /* Constant::getNullValue */
+#include "llvm/IR/Constants.h"             /* ConstantDataArray, ConstantExpr */
 #include "llvm/IR/IRBuilder.h"             /* IRBuilder */
 #include "llvm/IR/LLVMContext.h"           /* LLVMContext */
 #include "llvm/IR/GlobalValue.h"           /* GlobaleVariable, LinkageTypes */
+#include "llvm/IR/MDBuilder.h"             /* MDBuilder */
 #include "llvm/Analysis/Verifier.h"        /* verifyFunction, verifyModule */
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CFG.h"              /* pred_begin, pred_end */
 #include <llvm/Support/Host.h>
-
+#include "llvm/Support/TargetSelect.h"     /* InitializeNativeTarget */
+#include "llvm/Support/FormattedStream.h"  /* formatted_raw_ostream */
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Bitcode/ReaderWriter.h"     /* WriteBitcodeToFile */
+#include "llvm/ExecutionEngine/ExecutionEngine.h" /* EngineBuilder */
+#include "llvm/ExecutionEngine/MCJIT.h"    /* links in the MCJIT */
+#include "llvm/Support/DynamicLibrary.h"   /* LoadLibraryPermanently */
 #include "llvm/PassManager.h"
-#include "llvm/Transforms/Scalar.h"
+#include "llvm/Support/Dwarf.h"            /* DW_LANG_C99 */
+#include "llvm/Support/FileSystem.h"       /* current_path */
+#include "llvm/Support/Path.h"             /* sys::path::filename */
 
 #include "../parser/semadecl.h"
 #include "../parser/ast.h"
@@ -25,15 +37,46 @@
                 llvm::Value* rhs, int index)
 #define UNCREATE(X) llvm::Value* Codegeneration::IRCreator::X(llvm::Value* val)
 #define ALLOCF(X) llvm::Value* Codegeneration::IRCreator::X(std::string name)
-#define PREPARE(X) this->convert(X, this->USUALTYPE)
+#define PREPARE(X) this->promote(X)
+
+namespace {
+  /* Gives module the triple and the data layout of the host before the
+   * IRCreator computes any struct layout; the backend lays the structs out
+   * the same way then */
+  llvm::Module* targetHost(llvm::Module & module)
+  {
+    module.setTargetTriple(llvm::sys::getDefaultTargetTriple());
+    Codegeneration::createHostTargetMachine(module);
+    return &module;
+  }
+}
 
-Codegeneration::IRCreator::IRCreator(const char* filename):
+Codegeneration::IRCreator::IRCreator(const char* filename,
+                                     const Options & options):
   M(filename, llvm::getGlobalContext()),
-  Builder(M.getContext()), AllocaBuilder(M.getContext()),
-  currentFunction(nullptr), currentBreakPoint(nullptr), currentContinuePoint(nullptr)
+  DL(targetHost(M)), Builder(M.getContext()), AllocaBuilder(M.getContext()),
+  currentFunction(nullptr), currentBreakPoint(nullptr), currentContinuePoint(nullptr),
+  currentSwitch(nullptr),
+  useTBAA(options.typeBasedAliasAnalysis), tbaaChar(nullptr),
+  optimized(options.optLevel != OptLevel::O0), debugScope(nullptr),
+  instrument(options.instrument), profileOutput(options.profileOutput),
+  profileCounters(nullptr), branchesInFunction(0),
+  unrollCount(options.unrollCount), vectorize(options.vectorize),
+  typeCacheHits(0), typeCacheMisses(0)
 {
+  if (!options.profileInput.empty()) {
+    profile.reset(new BranchProfile(options.profileInput));
+  }
+  if (options.debugInfo) {
+    // finalize expects a compile unit, even without functions
+    llvm::SmallString<128> directory;
+    llvm::sys::fs::current_path(directory);
+    debugInfo.reset(new llvm::DIBuilder(M));
+    debugInfo->createCompileUnit(llvm::dwarf::DW_LANG_C99, filename,
+                                 directory, "c4", optimized, "", 0);
+    debugFile = debugInfo->createFile(filename, directory);
+  }
 
-  M.setTargetTriple(llvm::sys::getDefaultTargetTriple());
   mapLabel = std::map<std::string, llvm::BasicBlock* > ();
   //IMPORTANT: CHANGE USUALTYPE HERE IF NECESSARY
   USUALTYPE = Builder.getInt32Ty();
@@ -43,12 +86,48 @@ Codegeneration::IRCreator::~IRCreator()
 {
 }
 
-void Codegeneration::IRCreator::optimize()
+void Codegeneration::IRCreator::finishModule()
+{
+  if (debugInfo) {
+    debugInfo->finalize();
+    M.addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                    llvm::DEBUG_METADATA_VERSION);
+  }
+  if (!instrument) {
+    return;
+  }
+  auto type = llvm::ArrayType::get(Builder.getInt64Ty(),
+                                   2 * profileBranches.size());
+  auto counters = new llvm::GlobalVariable(M, type, false,
+      llvm::GlobalValue::InternalLinkage, llvm::Constant::getNullValue(type),
+      "c4.profile.counters");
+  if (profileCounters) {
+    counters->takeName(profileCounters);
+    profileCounters->replaceAllUsesWith(
+        llvm::ConstantExpr::getBitCast(counters, profileCounters->getType()));
+    profileCounters->eraseFromParent();
+    profileCounters = nullptr;
+  }
+  emitProfileWriter(M, counters, profileBranches, profileOutput);
+}
+
+/*
+ * with more than one worker, the functions are optimized in parallel, see
+ * optimizeFunctionsInParallel
+ */
+void Codegeneration::IRCreator::optimize(const Options & options)
+{
+  if (options.optimizationWorkers > 1) {
+    optimizeFunctionsInParallel(M, options);
+  } else {
+    optimizeModule(M, options);
+  }
+}
+
+void Codegeneration::IRCreator::printStatistics(llvm::raw_ostream & out)
 {
-    llvm::PassManager PM;
-    PM.add(llvm::createPromoteMemoryToRegisterPass());
-    PM.add(new SCCP_Pass());
-    PM.run(M);
+  out << "type lowering cache: " << typeCacheHits << " hits, "
+      << typeCacheMisses << " misses\n";
 }
 
 void Codegeneration::IRCreator::print(llvm::raw_fd_ostream & out)
@@ -57,6 +136,59 @@ void Codegeneration::IRCreator::print(llvm::raw_fd_ostream & out)
   M.print(out, nullptr); /* M is a llvm::Module */
 }
 
+void Codegeneration::IRCreator::writeBitcode(llvm::raw_fd_ostream & out)
+{
+  verifyModule(M);
+  llvm::WriteBitcodeToFile(&M, out);
+}
+
+void Codegeneration::IRCreator::emitMachineCode(llvm::raw_fd_ostream & out,
+    llvm::TargetMachine::CodeGenFileType type)
+{
+  verifyModule(M);
+  auto machine = createHostTargetMachine(M);
+
+  llvm::PassManager PM;
+  PM.add(new llvm::DataLayout(*machine->getDataLayout()));
+  llvm::formatted_raw_ostream formatted(out);
+  if (machine->addPassesToEmitFile(PM, formatted, type)) {
+    throw std::runtime_error("the target " + M.getTargetTriple()
+                             + " cannot emit this kind of file");
+  }
+  PM.run(M);
+}
+
+int Codegeneration::IRCreator::run(const std::vector<std::string> & arguments)
+{
+  verifyModule(M);
+  auto mainFunction = M.getFunction("main");
+  if (!mainFunction || mainFunction->isDeclaration()) {
+    throw std::runtime_error("cannot run a program without a main function");
+  }
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  // functions which are only declared, like malloc and printf, are looked up
+  // in the running process
+  llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+
+  std::string error;
+  std::unique_ptr<llvm::ExecutionEngine> engine(llvm::EngineBuilder(&M)
+      .setErrorStr(&error)
+      .setEngineKind(llvm::EngineKind::JIT)
+      .setUseMCJIT(true)
+      .create());
+  if (!engine) {
+    throw std::runtime_error("cannot create the JIT: " + error);
+  }
+  engine->finalizeObject();
+  engine->runStaticConstructorsDestructors(false);
+  auto result = engine->runFunctionAsMain(mainFunction, arguments, nullptr);
+  engine->runStaticConstructorsDestructors(true);
+  // M belongs to us, not to the engine
+  engine->removeModule(&M);
+  return result;
+}
+
 llvm::Value *Codegeneration::IRCreator::allocateInCurrentFunction(llvm::Type* type)
 {
     /* Reset the alloca builder each time before using it
@@ -69,19 +201,210 @@ llvm::Value *Codegeneration::IRCreator::allocateInCurrentFunction(llvm::Type* ty
   return AllocaBuilder.CreateAlloca(type);
 }
 
+bool Codegeneration::IRCreator::canPromote(
+    const Parsing::SemanticDeclarationNode variable)
+{
+  if (variable->addressTaken) {
+    return false;
+  }
+  switch (variable->type()) {
+    case Semantic::Type::INT:
+    case Semantic::Type::CHAR:
+    case Semantic::Type::LONG:
+    case Semantic::Type::UNSIGNED:
+    case Semantic::Type::UNSIGNED_LONG:
+      return true;
+    case Semantic::Type::POINTER:
+      // calls through function pointers expect the stack slot
+      return std::static_pointer_cast<Parsing::PointerDeclaration>(variable)
+        ->pointee()->type() != Semantic::Type::FUNCTION;
+    default:
+      return false;
+  }
+}
+
+void Codegeneration::IRCreator::declareVariable(
+    const Parsing::SemanticDeclarationNode variable,
+    llvm::Type* type,
+    std::string name)
+{
+  // reading the variable before the first assignment yields an undefined value
+  declareVariable(variable, llvm::UndefValue::get(type), name);
+}
+
+void Codegeneration::IRCreator::declareVariable(
+    const Parsing::SemanticDeclarationNode variable,
+    llvm::Value* initialValue,
+    std::string name)
+{
+  ssaVariables[variable.get()] = SSAVariable {initialValue->getType(), name};
+  writeVariable(variable.get(), Builder.GetInsertBlock(), initialValue);
+}
+
+bool Codegeneration::IRCreator::isSSAVariable(
+    const Parsing::SemanticDeclarationNode variable)
+{
+  return ssaVariables.count(variable.get());
+}
+
+llvm::Value* Codegeneration::IRCreator::readVariable(
+    const Parsing::SemanticDeclarationNode variable)
+{
+  return readVariable(variable.get(), Builder.GetInsertBlock());
+}
+
+/*
+ * The counterpart of createAssign for variables in SSA form: the converted
+ * value becomes the current definition of the variable
+ */
+llvm::Value* Codegeneration::IRCreator::assignVariable(
+    const Parsing::SemanticDeclarationNode variable,
+    llvm::Value* rhs, llvm::Type* type)
+{
+  if (this->isVoidP(rhs->getType())
+      || (this->isVoidP(type) && rhs->getType()->isPointerTy())) {
+    rhs = Builder.CreateBitCast(rhs, type);
+  } else {
+    rhs = this->convert(rhs, type);
+  }
+  writeVariable(variable.get(), Builder.GetInsertBlock(), rhs);
+  return rhs;
+}
+
+void Codegeneration::IRCreator::writeVariable(Variable variable,
+    llvm::BasicBlock* block, llvm::Value* value)
+{
+  currentDef[block][variable] = value;
+}
+
+llvm::Value* Codegeneration::IRCreator::readVariable(Variable variable,
+    llvm::BasicBlock* block)
+{
+  auto & definitions = currentDef[block];
+  auto definition = definitions.find(variable);
+  if (definition != definitions.end()) {
+    return definition->second;
+  }
+  return readVariableRecursive(variable, block);
+}
+
+llvm::Value* Codegeneration::IRCreator::readVariableRecursive(Variable variable,
+    llvm::BasicBlock* block)
+{
+  llvm::Value* value;
+  if (!sealedBlocks.count(block)) {
+    // not all predecessors are known yet, the operands are added by sealBlock
+    auto phi = createPhi(variable, block);
+    incompletePhis[block].push_back(std::make_pair(variable, phi));
+    value = phi;
+  } else if (auto predecessor = block->getSinglePredecessor()) {
+    // no phi needed
+    value = readVariable(variable, predecessor);
+  } else if (llvm::pred_begin(block) == llvm::pred_end(block)) {
+    // unreachable code
+    value = llvm::UndefValue::get(ssaVariables[variable].type);
+  } else {
+    // the phi breaks cycles in the control flow graph
+    auto phi = createPhi(variable, block);
+    writeVariable(variable, block, phi);
+    value = addPhiOperands(variable, phi);
+  }
+  writeVariable(variable, block, value);
+  return value;
+}
+
+llvm::PHINode* Codegeneration::IRCreator::createPhi(Variable variable,
+    llvm::BasicBlock* block)
+{
+  auto & info = ssaVariables[variable];
+  if (block->empty()) {
+    return llvm::PHINode::Create(info.type, 0, info.name, block);
+  }
+  return llvm::PHINode::Create(info.type, 0, info.name, &block->front());
+}
+
+llvm::Value* Codegeneration::IRCreator::addPhiOperands(Variable variable,
+    llvm::PHINode* phi)
+{
+  auto block = phi->getParent();
+  for (auto predecessor = llvm::pred_begin(block);
+       predecessor != llvm::pred_end(block); ++predecessor) {
+    phi->addIncoming(readVariable(variable, *predecessor), *predecessor);
+  }
+  return tryRemoveTrivialPhi(phi);
+}
+
+/*
+ * A phi which only merges one value (and maybe itself) is replaced by that
+ * value. This can make phis using it trivial, too.
+ */
+llvm::Value* Codegeneration::IRCreator::tryRemoveTrivialPhi(llvm::PHINode* phi)
+{
+  llvm::Value* same = nullptr;
+  for (unsigned i = 0; i < phi->getNumIncomingValues(); ++i) {
+    auto operand = phi->getIncomingValue(i);
+    if (operand == same || operand == phi) {
+      continue;
+    }
+    if (same) {
+      // the phi merges at least two values
+      return phi;
+    }
+    same = operand;
+  }
+  if (!same) {
+    // the phi is unreachable or in the entry block
+    same = llvm::UndefValue::get(phi->getType());
+  }
+  // other phis may become trivial; the handles notice if one of them is
+  // removed while we are still working on the list
+  std::vector<llvm::WeakVH> users;
+  for (auto user = phi->use_begin(); user != phi->use_end(); ++user) {
+    if (*user != phi && llvm::isa<llvm::PHINode>(*user)) {
+      users.push_back(llvm::WeakVH(*user));
+    }
+  }
+  phi->replaceAllUsesWith(same);
+  phi->eraseFromParent();
+  // same itself may be one of the phis that are removed below
+  llvm::WeakVH result(same);
+  for (auto & user : users) {
+    llvm::Value* value = user;
+    if (auto userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(value)) {
+      tryRemoveTrivialPhi(userPhi);
+    }
+  }
+  return result;
+}
+
+void Codegeneration::IRCreator::sealBlock(llvm::BasicBlock* block)
+{
+  if (!sealedBlocks.insert(block).second) {
+    return;
+  }
+  // addPhiOperands may add phis to other blocks, but never to this one
+  auto pending = std::move(incompletePhis[block]);
+  incompletePhis.erase(block);
+  for (auto & incomplete : pending) {
+    addPhiOperands(incomplete.first, incomplete.second);
+  }
+}
+
 llvm::Value* Codegeneration::IRCreator::createLoad(llvm::Value* val) {
   return Builder.CreateLoad(val);
 }
 
 
-void Codegeneration::IRCreator::store(llvm::Value* value, llvm::Value *ptr) {
-  Builder.CreateStore(value,ptr);
+void Codegeneration::IRCreator::store(llvm::Value* value, llvm::Value *ptr,
+                                      llvm::MDNode* tag) {
+  tagAccess(Builder.CreateStore(value,ptr), tag);
 }
 
 llvm::Function* Codegeneration::IRCreator::startFunction(
     llvm::FunctionType* function_type,
     std::string name,
-    bool definition
+    bool definition,
+    bool internal
 )
 {
 
@@ -90,7 +413,8 @@ llvm::Function* Codegeneration::IRCreator::startFunction(
 
   auto function = llvm::Function::Create(
       function_type,
-      llvm::GlobalValue::ExternalLinkage,
+      internal ? llvm::GlobalValue::InternalLinkage
+               : llvm::GlobalValue::ExternalLinkage,
       name,
       &M
       );
@@ -113,8 +437,10 @@ llvm::Function* Codegeneration::IRCreator::startAlreadyDefinedFunction(
       0 //InsertBefore: inserts at end of surrounding function?
       );
   currentFunction = function;
+  branchesInFunction = 0;
   Builder.SetInsertPoint(function_basic_block);
   AllocaBuilder.SetInsertPoint(function_basic_block);
+  sealBlock(function_basic_block);
   return function;
 }
 
@@ -123,12 +449,12 @@ void Codegeneration::IRCreator::finishFunction()
   // stol^H^H^H^H borrowed from Johannes' example
   /* All code was emitted,.. but the last block might be empty.
    * If the last block does not end with a terminator statement the simple
-   * rules created either dead code or the function is a void function without
-   * a return on each path. Either way we need to add a terminator instruction
+   * rules created a function without a return on each path, either a void
+   * function or one which relies on undefined behaviour. Either way we need to add a terminator instruction
    * to the last block. The idea is to look at the return type of the current
    * function and emit either a void return or a return with the 'NULL' value
    * for this type */
-  if (Builder.GetInsertBlock()->getTerminator() == nullptr) {
+  if (isReachable() && Builder.GetInsertBlock()->getTerminator() == nullptr) {
     auto CurFuncReturnType = Builder.getCurrentFunctionReturnType();
     if (CurFuncReturnType->isVoidTy()) {
       Builder.CreateRetVoid();
@@ -136,7 +462,45 @@ void Codegeneration::IRCreator::finishFunction()
       Builder.CreateRet(llvm::Constant::getNullValue(CurFuncReturnType));
     }
   }
+  // now all edges are known, in particular those created by goto
+  for (auto & block : *currentFunction) {
+    sealBlock(&block);
+  }
+  ssaVariables.clear();
+  currentDef.clear();
+  incompletePhis.clear();
+  sealedBlocks.clear();
   currentFunction = nullptr;
+  debugScope = nullptr;
+  Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+}
+
+/*
+ * Only line tables are emitted: there are no types and no variables, the
+ * subprograms only carry names and lines
+ */
+void Codegeneration::IRCreator::describeFunction(llvm::Function* function,
+                                                 const Pos & pos)
+{
+  if (!debugInfo) {
+    return;
+  }
+  auto type = debugInfo->createSubroutineType(debugFile,
+      debugInfo->getOrCreateArray(llvm::ArrayRef<llvm::Value*>()));
+  llvm::DISubprogram subprogram = debugInfo->createFunction(
+      debugFile, function->getName(), function->getName(), debugFile,
+      pos.line, type, function->hasLocalLinkage(), true, pos.line, 0,
+      optimized, function);
+  debugScope = subprogram;
+  setDebugLocation(pos);
+}
+
+void Codegeneration::IRCreator::setDebugLocation(const Pos & pos)
+{
+  if (debugScope) {
+    Builder.SetCurrentDebugLocation(
+        llvm::DebugLoc::get(pos.line, pos.column, debugScope));
+  }
 }
 
 
@@ -159,19 +523,9 @@ void Codegeneration::IRCreator::makeReturn(llvm::Value *value) {
     Builder.CreateRetVoid();
   }
 
-  /* Always create a new block after a return statement
-   *
-   *  This will prevent you from inserting code after a block terminator (here
-   *  the return instruction), but it will create a dead basic block instead.
-   */
-  llvm::BasicBlock *ReturnDeadBlock = llvm::BasicBlock::Create(
-          Builder.getContext()                   /* LLVMContext &Context */,
-          "DEAD_BLOCK"                            /* const Twine &Name="" */,
-          currentFunction                         /* Function *Parent=0 */,
-          0                                       /* BasicBlock *InsertBefore=0 */);
-
-  /* Insert code following the return in this new 'dead' block */
-  Builder.SetInsertPoint(ReturnDeadBlock);
+  /* No code may follow the return in its block; until a label is reached,
+   * the statements after it are not emitted at all */
+  Builder.ClearInsertionPoint();
 }
 
 
@@ -201,7 +555,9 @@ llvm::BasicBlock* Codegeneration::IRCreator::makeBlock(std::string labelName, bo
 
   if (connect) {
      /* Insert an unconditional branch from the current basic block to the header of the IfStmt */
-     Builder.CreateBr(labelBlock);
+     if (isReachable()) {
+       Builder.CreateBr(labelBlock);
+     }
      /* Set the header of the IfStmt as the new insert point */
      Builder.SetInsertPoint(labelBlock);
    }
@@ -226,12 +582,75 @@ void Codegeneration::IRCreator::makeConditonalBranch(
     llvm::BasicBlock* consequenceBlock,
     llvm::BasicBlock* alternativeBlock)
 {
-  if(! branchCondition->getType()->isPointerTy())
-    branchCondition = Builder.CreateSExt(branchCondition, Builder.getInt32Ty());
-  else
-    branchCondition = Builder.CreatePtrToInt(branchCondition, Builder.getInt32Ty());
-  branchCondition = Builder.CreateICmpNE(branchCondition, llvm::Constant::getNullValue(Builder.getInt32Ty()));
-  Builder.CreateCondBr(branchCondition, consequenceBlock, alternativeBlock);
+  auto condition = isNonZero(branchCondition);
+  BranchId id {llvm::sys::path::filename(M.getModuleIdentifier()).str(),
+               currentFunction->getName().str(), branchesInFunction++};
+  if (instrument) {
+    // counts the edge taken, without splitting it
+    if (!profileCounters) {
+      profileCounters = new llvm::GlobalVariable(M, Builder.getInt64Ty(),
+          false, llvm::GlobalValue::InternalLinkage, Builder.getInt64(0),
+          "c4.profile.counters");
+    }
+    unsigned index = 2 * profileBranches.size();
+    profileBranches.push_back(id);
+    auto counter = Builder.CreateGEP(profileCounters, Builder.CreateSelect(
+        condition, Builder.getInt32(index), Builder.getInt32(index + 1)));
+    Builder.CreateStore(
+        Builder.CreateAdd(Builder.CreateLoad(counter), Builder.getInt64(1)),
+        counter);
+  }
+  auto branch = Builder.CreateCondBr(condition, consequenceBlock,
+                                     alternativeBlock);
+  if (profile) {
+    if (auto counts = profile->find(id)) {
+      branch->setMetadata(llvm::LLVMContext::MD_prof,
+                          branchWeights(M.getContext(), *counts));
+    }
+  }
+}
+
+void Codegeneration::IRCreator::markLoop(llvm::BasicBlock* latch)
+{
+  auto & context = M.getContext();
+  // the first operand is the node itself, which keeps the nodes of different
+  // loops apart
+  auto self = llvm::MDNode::getTemporary(context, llvm::ArrayRef<llvm::Value*>());
+  std::vector<llvm::Value*> operands(1, self);
+  if (unrollCount) {
+    llvm::Value* hint[] = {
+      llvm::MDString::get(context, "llvm.loop.unroll.count"),
+      Builder.getInt32(unrollCount),
+    };
+    operands.push_back(llvm::MDNode::get(context, hint));
+  }
+  if (vectorize) {
+    llvm::Value* hint[] = {
+      llvm::MDString::get(context, "llvm.vectorizer.enable"),
+      Builder.getInt1(true),
+    };
+    operands.push_back(llvm::MDNode::get(context, hint));
+  }
+  auto loop = llvm::MDNode::get(context, operands);
+  loop->replaceOperandWith(0, loop);
+  llvm::MDNode::deleteTemporary(self);
+
+  latch->getTerminator()->setMetadata("llvm.loop", loop);
+}
+
+llvm::Value* Codegeneration::IRCreator::isNonZero(llvm::Value* value)
+{
+  // null has the type of value, so no bits of a long or a pointer are lost
+  return Builder.CreateICmpNE(value, llvm::Constant::getNullValue(value->getType()));
+}
+
+llvm::Value* Codegeneration::IRCreator::promote(llvm::Value* value)
+{
+  if (value->getType()->isIntegerTy()
+      && value->getType()->getIntegerBitWidth() < USUALTYPE->getIntegerBitWidth()) {
+    return Builder.CreateSExt(value, USUALTYPE);
+  }
+  return value;
 }
 
 llvm::BasicBlock* Codegeneration::IRCreator::getCurrentBlock() {
@@ -240,27 +659,59 @@ llvm::BasicBlock* Codegeneration::IRCreator::getCurrentBlock() {
 
 void Codegeneration::IRCreator::connect(llvm::BasicBlock* to)
 {
-  auto from = Builder.GetInsertBlock();
-  llvm::BranchInst::Create(to, from);
+  connect(nullptr, to);
 }
 
 llvm::BasicBlock* Codegeneration::IRCreator::connect(llvm::BasicBlock* from, llvm::BasicBlock* to)
 {
   if (!from) {
     from = Builder.GetInsertBlock();
+    if (!from) {
+      return nullptr;
+    }
   }
   llvm::BranchInst::Create(to, from);
   return from;
 }
 
+void Codegeneration::IRCreator::makeJump(llvm::BasicBlock* to)
+{
+  connect(to);
+  Builder.ClearInsertionPoint();
+}
 
-llvm::GlobalVariable *Codegeneration::IRCreator::makeGlobVar(llvm::Type *type)
+bool Codegeneration::IRCreator::isReachable()
 {
+  return Builder.GetInsertBlock() != nullptr;
+}
+
+bool Codegeneration::IRCreator::enterIfReachable(llvm::BasicBlock* block)
+{
+  if (llvm::pred_begin(block) == llvm::pred_end(block)) {
+    // nothing was read or written in the block yet
+    sealedBlocks.erase(block);
+    incompletePhis.erase(block);
+    currentDef.erase(block);
+    block->eraseFromParent();
+    Builder.ClearInsertionPoint();
+    return false;
+  }
+  Builder.SetInsertPoint(block);
+  return true;
+}
+
+
+llvm::GlobalVariable *Codegeneration::IRCreator::makeGlobVar(llvm::Type *type,
+                                                             bool internal)
+{
+  // internal variables are not merged with the ones of other modules, so
+  // their zero initializer is known to the optimizer
   return  new llvm::GlobalVariable(
           M                                      /* Module & */,
           type                              /* Type * */,
           false                                   /* bool isConstant */,
-          llvm::GlobalValue::CommonLinkage              /* LinkageType */,
+          internal ? llvm::GlobalValue::InternalLinkage
+                   : llvm::GlobalValue::CommonLinkage    /* LinkageType */,
           llvm::Constant::getNullValue(type)      /* Constant * Initializer */,
           "TODO"                                /* const Twine &Name = "" */,
           /*--------- We do not need this part (=> use defaults) ----------*/
@@ -273,8 +724,10 @@ llvm::GlobalVariable *Codegeneration::IRCreator::makeGlobVar(llvm::Type *type)
 
 /*
  * Self explanatory binary expression functions. Special cases are annotated.
- * Casting is done with the PREPARE makro, which makes use of the convert 
- * function so that we do not create unnecessary casts.
+ * Casting is done with the PREPARE makro, which makes use of the promote
+ * function so that we do not create unnecessary casts. Operands wider than
+ * USUALTYPE are kept; the code generator has already converted them to the
+ * type of the usual arithmetic conversions.
  */
 BINCREATE(createAdd) {
         lhs = PREPARE(lhs);
@@ -288,8 +741,8 @@ BINCREATE(createAdd) {
  * GEP
  */
 BINCREATE(createPAdd) {
-        if(rhs->getType() !=  Builder.getInt32Ty())
-                rhs = Builder.CreateSExtOrTrunc(rhs,Builder.getInt32Ty());
+        // the offset must not be truncated, so it has pointer width
+        rhs = convert(rhs, indexType());
         return Builder.CreateGEP(lhs, rhs);
 }
 
@@ -297,8 +750,7 @@ BINCREATE(createPAdd) {
  * Same as for createPAdd
  */
 BINCREATE(createPMinus){
-        if(rhs->getType() != Builder.getInt32Ty())
-                rhs = Builder.CreateSExtOrTrunc(rhs, Builder.getInt32Ty());
+        rhs = convert(rhs, indexType());
         // we have to negate subtract, as rhs is positive in lhs - rhs
         rhs = Builder.CreateNeg(rhs);
         return Builder.CreateGEP(lhs, rhs);
@@ -307,11 +759,11 @@ BINCREATE(createPMinus){
 /*
  * We need to produce the number of elements between the two pointers.
  * As llvm offers a method to compute PtrDiff and we already did type checking 
- * it is safe to use it here.
+ * it is safe to use it here. The difference is a ptrdiff_t, i.e. a long.
  */
 BINCREATE(createPPMinus) {
         llvm::Value* val = Builder.CreatePtrDiff(lhs, rhs);
-        return convert(val, Builder.getInt32Ty());
+        return convert(val, indexType());
 }
 
 
@@ -322,11 +774,12 @@ BINCREATE(createMinus) {
 }
 
 /*
- * We use signed less than for the less than operator as usual arithmetic 
- * conversions imply an implicit threatment of all values as i32 integer 
- * which are signed in our C subset
+ * We use signed less than for the less than operator, unless the usual
+ * arithmetic conversions yielded an unsigned type; the code generator has
+ * already converted both operands to that type
  */
-BINCREATE(createLess) {
+llvm::Value* Codegeneration::IRCreator::createLess(llvm::Value* lhs,
+    llvm::Value* rhs, bool isUnsigned) {
   if(this->isVoidP(lhs->getType())){
     if(! this->isVoidP(rhs->getType())){ //right is no void pointer --> cast
       //right could be a NullPointerConst
@@ -360,7 +813,8 @@ BINCREATE(createLess) {
   if (lhs->getType() != rhs->getType()) {
     lhs = Builder.CreateBitCast(lhs, rhs->getType());
   }
-  auto as_i1 = Builder.CreateICmpSLT(lhs,rhs);
+  auto as_i1 = isUnsigned ? Builder.CreateICmpULT(lhs, rhs)
+                          : Builder.CreateICmpSLT(lhs, rhs);
   // the comparision returns an i1, but what we need is a int32
   return Builder.CreateZExtOrTrunc(as_i1, Builder.getInt32Ty());
 }
@@ -449,31 +903,8 @@ BINCREATE(createEqual){
   return Builder.CreateZExtOrTrunc(as_i1, Builder.getInt32Ty());
 }
 
-BINCREATE(createLogAnd){
-  bool rhsPointer = rhs->getType()->isPointerTy();
-  if(lhs->getType()->isPointerTy()){
-    lhs = (rhsPointer? lhs : Builder.CreatePtrToInt(lhs, USUALTYPE));
-    rhs = (rhsPointer? rhs :PREPARE(rhs));
-  }else{
-    rhs = (rhsPointer? Builder.CreatePtrToInt(rhs, USUALTYPE):PREPARE(rhs));
-    lhs = PREPARE(lhs);
-  }
-  return Builder.CreateAnd(lhs, rhs);
-}
-
-BINCREATE(createLogOr){
-  bool rhsPointer = rhs->getType()->isPointerTy();
-  if(lhs->getType()->isPointerTy()){
-    lhs = (rhsPointer? lhs : Builder.CreatePtrToInt(lhs, USUALTYPE));
-    rhs = (rhsPointer? rhs :PREPARE(rhs));
-  }else{
-    rhs = (rhsPointer? Builder.CreatePtrToInt(rhs, USUALTYPE):PREPARE(rhs));
-    lhs = PREPARE(lhs);
-  }	return Builder.CreateOr(lhs,rhs);
-}
-
 BINCREATE(createArrayAccess){
-        llvm::Value* val= Builder.CreateGEP(lhs, rhs);
+        llvm::Value* val= Builder.CreateGEP(lhs, convert(rhs, indexType()));
         return Builder.CreateLoad(val);
 }
 
@@ -517,7 +948,7 @@ BINCREATEL(createAccess) {
  * semantic checking already validated it, this should not cause troubles.
  */
 llvm::Value* Codegeneration::IRCreator::createAssign(llvm::Value* lhs, 
-                llvm::Value* rhs, llvm::Type* type) {
+                llvm::Value* rhs, llvm::Type* type, llvm::MDNode* tag) {
   if(this->isVoidP(rhs->getType())){
     rhs = Builder.CreateBitCast(rhs, type);
   }else if(this->isVoidPP(lhs->getType())){
@@ -525,7 +956,7 @@ llvm::Value* Codegeneration::IRCreator::createAssign(llvm::Value* lhs,
   }else{ //No void pointers involved
   rhs = this->convert(rhs, type);
   }
-  store(rhs,lhs);
+  store(rhs,lhs,tag);
   return rhs;
 
 }
@@ -562,27 +993,23 @@ BINCREATEL(getMemberAddress){
 
 /*
  * Array accesses are just another style of writing pointer arithmetics.
- * A[1] is the same as A + 1 
+ * A[1] is the same as A + 1, so lhs is the rvalue of A
  */
 BINCREATEL(getArrayPosition) {
         UNUSED(index);
-        llvm::Value* val = Builder.CreateLoad(lhs);
-        return Builder.CreateGEP(val,rhs);
+        return Builder.CreateGEP(lhs, convert(rhs, indexType()));
 //        UNUSED(index);
 //        lhs = Builder.CreateSExt(lhs, Builder.getInt32Ty());
 //        rhs = Builder.CreateSExt(rhs, Builder.getInt32Ty());
 //	return Builder.CreateAdd(lhs,rhs);
 }
 
+/*
+ * The result is an int, whatever the type of the operand is
+ */
 UNCREATE(createLogNeg) {
-  if(val->getType()->isPointerTy()){
-    auto type = val->getType();
-    val = Builder.CreatePtrToInt(val, Builder.getInt32Ty());
-    val = Builder.CreateNot(val);
-    return Builder.CreateIntToPtr(val, type);
-   }else{
-    return Builder.CreateNot(val);
-   }
+  auto as_i1 = Builder.CreateNot(isNonZero(val));
+  return Builder.CreateZExt(as_i1, Builder.getInt32Ty());
 }
 
 UNCREATE(createNeg) { 
@@ -605,8 +1032,8 @@ UNCREATE(createDeref) {
 
 llvm::Value* Codegeneration::IRCreator::createSizeof(llvm::Type* type)
 {
-  auto val = llvm::ConstantExpr::getSizeOf(type);
-  return Builder.CreateSExtOrTrunc(val,  Builder.getInt32Ty());
+  // an i64, which is the lowered size_t
+  return llvm::ConstantExpr::getSizeOf(type);
 }
 
 llvm::Value* Codegeneration::IRCreator::loadVariable(
@@ -620,7 +1047,21 @@ llvm::Value* Codegeneration::IRCreator::loadVariable(
 ALLOCF(allocLiteral) {
   // FIXME: maybe we should have done this in the lexer
   auto unescaped = name;
-  return Builder.CreateGlobalStringPtr(llvm::StringRef(unescaped));
+  auto & literal = stringLiterals[unescaped];
+  if (!literal) {
+    // literals can't be modified and their addresses may not be compared,
+    // so all occurrences share one global, which LLVM may merge further
+    auto initializer = llvm::ConstantDataArray::getString(
+        M.getContext(), unescaped, true);
+    auto global = new llvm::GlobalVariable(
+        M, initializer->getType(), true,
+        llvm::GlobalValue::PrivateLinkage, initializer, ".str");
+    global->setUnnamedAddr(true);
+    llvm::Constant* zero = Builder.getInt32(0);
+    llvm::Constant* indices[] = {zero, zero};
+    literal = llvm::ConstantExpr::getInBoundsGetElementPtr(global, indices);
+  }
+  return literal;
 }
 
 llvm::Value* Codegeneration::IRCreator::allocChar (char val) {
@@ -631,57 +1072,27 @@ llvm::Value* Codegeneration::IRCreator::allocInt(int val){
   return Builder.getInt32(val);
 }
 
+llvm::Value* Codegeneration::IRCreator::allocLong(long long val){
+  return Builder.getInt64(val);
+}
+
 llvm::Value* Codegeneration::IRCreator::allocNullptr(llvm::Type* type) {
   if (type->isPointerTy()) {
     return llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(type));
   } else if (type->isIntegerTy()) {
-    return Builder.getInt32(0);
+    return llvm::Constant::getNullValue(type);
   } else {
     return llvm::ConstantPointerNull::get(llvm::PointerType::getUnqual(Builder.getInt32Ty()));
   }
 }
 
-llvm::Value* Codegeneration::IRCreator::makeSelect(Parsing::SubExpression cond,
-                Parsing::SubExpression lhs, Parsing::SubExpression rhs) {
-        llvm::BasicBlock* left = getControlFlowBlock();
-        llvm::BasicBlock* right = getControlFlowBlock();
-        llvm::BasicBlock* term = getControlFlowBlock();
-        llvm::Value* branch = cond->emit_rvalue(this);
-        makeConditonalBranch(branch, left, right);
-        setCurrentBasicBlock(left);
-        llvm::Value* vall = lhs->emit_rvalue(this);
-        vall = Builder.CreateSExt(vall, Builder.getInt32Ty());
-        Builder.CreateBr(term);
-        setCurrentBasicBlock(right);
-        llvm::Value* valr = rhs->emit_rvalue(this);
-        valr = Builder.CreateSExt(valr, Builder.getInt32Ty());
-        Builder.CreateBr(term);
-        setCurrentBasicBlock(term);
-        llvm::Value* phi = Builder.CreatePHI(Builder.getInt32Ty(), 2);
-        return phi;
-}
-
-llvm::Value* Codegeneration::IRCreator::makeSelectLV(Parsing::SubExpression cond,
-                Parsing::SubExpression lhs, Parsing::SubExpression rhs){
-        llvm::BasicBlock* left = getControlFlowBlock();
-        llvm::BasicBlock* right = getControlFlowBlock();
-        llvm::BasicBlock* term = getControlFlowBlock();
-        llvm::Value* branch = cond->emit_rvalue(this);
-        makeConditonalBranch(branch, left, right);
-        setCurrentBasicBlock(left);
-        llvm::Value* vall = lhs->emit_lvalue(this);
-        vall = Builder.CreateSExt(vall, Builder.getInt32Ty());
-        Builder.CreateBr(term);
-        setCurrentBasicBlock(right);
-        llvm::Value* valr = rhs->emit_lvalue(this);
-        valr = Builder.CreateSExt(valr, Builder.getInt32Ty());
-        Builder.CreateBr(term);
-        setCurrentBasicBlock(term);
-        llvm::Value* phi = Builder.CreatePHI(Builder.getInt32Ty(), 2);
-        return phi;
+llvm::Value* Codegeneration::IRCreator::makeSelect(llvm::Value* condition,
+    llvm::Value* consequence, llvm::Value* alternative)
+{
+  return Builder.CreateSelect(isNonZero(condition), consequence, alternative,
+                              "select");
 }
 
-
 llvm::Value* Codegeneration::IRCreator::makePhi(
     llvm::BasicBlock* consequenceBlock,
     llvm::Value* consequenceValue,
@@ -739,19 +1150,187 @@ void Codegeneration::IRCreator::setCurrentContinuePoint(llvm::BasicBlock* block)
   currentContinuePoint = block;
 }
 
+llvm::BasicBlock* Codegeneration::IRCreator::getCurrentBreakPoint() {
+  return currentBreakPoint;
+}
+
+llvm::BasicBlock* Codegeneration::IRCreator::getCurrentContinuePoint() {
+  return currentContinuePoint;
+}
+
+llvm::SwitchInst* Codegeneration::IRCreator::makeSwitch(llvm::Value* value,
+    llvm::BasicBlock* defaultBlock)
+{
+  // the cases are added while the body is emitted
+  auto switchInst = Builder.CreateSwitch(PREPARE(value), defaultBlock);
+  Builder.ClearInsertionPoint();
+  return switchInst;
+}
+
+llvm::ConstantInt* Codegeneration::IRCreator::makeCaseValue(
+    llvm::SwitchInst* switchInst, int value)
+{
+  return llvm::ConstantInt::get(
+      llvm::cast<llvm::IntegerType>(switchInst->getCondition()->getType()),
+      value, true);
+}
+
+void Codegeneration::IRCreator::addSwitchLabel(llvm::SwitchInst* switchInst,
+    llvm::ConstantInt* value, llvm::BasicBlock* block)
+{
+  if (value) {
+    switchInst->addCase(value, block);
+  } else {
+    switchInst->setDefaultDest(block);
+  }
+}
+
+void Codegeneration::IRCreator::setCurrentSwitch(llvm::SwitchInst* switchInst) {
+  currentSwitch = switchInst;
+}
+
+llvm::SwitchInst* Codegeneration::IRCreator::getCurrentSwitch() {
+  return currentSwitch;
+}
+
 void Codegeneration::IRCreator::makeBreak() {
-  connect(currentBreakPoint);
+  makeJump(currentBreakPoint);
 }
 
 void Codegeneration::IRCreator::makeContinue() {
-  connect(currentContinuePoint);
+  makeJump(currentContinuePoint);
 }
 
 /*
  *  Converts one of our type classes to the corresponding LLVM Type
+ *  Structurally equal types share their canonical node, so each of them is
+ *  only lowered once per IRCreator
  */
 llvm::Type* Codegeneration::IRCreator::semantic_type2llvm_type(
     const Parsing::SemanticDeclarationNode semantic_type) {
+  auto key = Semantic::types().canonical(semantic_type);
+  auto cached = loweredTypes.find(key);
+  if (cached != loweredTypes.end()) {
+    ++typeCacheHits;
+    return cached->second;
+  }
+  ++typeCacheMisses;
+  auto llvm_type = lower_type(semantic_type);
+  loweredTypes[key] = llvm_type;
+  return llvm_type;
+}
+
+/*
+ * The type tree follows the one of clang, in the struct path format: an
+ * access through a struct member is tagged with the struct, the type of the
+ * member and its offset, so that accesses to different members of the same
+ * struct do not alias either
+ */
+llvm::MDNode* Codegeneration::IRCreator::tbaaTypeNode(
+    const Parsing::SemanticDeclarationNode type) {
+  if (!useTBAA) {
+    return nullptr;
+  }
+  auto key = Semantic::types().canonical(type);
+  auto cached = tbaaTypes.find(key);
+  if (cached != tbaaTypes.end()) {
+    return cached->second;
+  }
+  llvm::MDBuilder builder(M.getContext());
+  if (!tbaaChar) {
+    auto root = builder.createTBAARoot("Simple C/C++ TBAA");
+    tbaaChar = builder.createTBAAScalarTypeNode("omnipotent char", root);
+  }
+  llvm::MDNode* node = nullptr;
+  switch (type->type()) {
+    case Semantic::Type::CHAR:
+      node = tbaaChar;
+      break;
+    case Semantic::Type::INT:
+    case Semantic::Type::UNSIGNED:
+      // 6.5p7: the signed and unsigned variants of a type may alias, and the
+      // nodes are uniqued by their name
+      node = builder.createTBAAScalarTypeNode("int", tbaaChar);
+      break;
+    case Semantic::Type::LONG:
+    case Semantic::Type::UNSIGNED_LONG:
+      node = builder.createTBAAScalarTypeNode("long", tbaaChar);
+      break;
+    case Semantic::Type::POINTER:
+      node = builder.createTBAAScalarTypeNode("any pointer", tbaaChar);
+      break;
+    case Semantic::Type::STRUCT:
+      {
+      auto structType = std::static_pointer_cast<Parsing::StructDeclaration>(type);
+      // computes the layout of the struct
+      semantic_type2llvm_type(structType);
+      auto & members = structType->members();
+      std::vector<std::pair<llvm::MDNode*, uint64_t>> fields;
+      for (unsigned i = 0; i < members.size(); ++i) {
+        auto field = tbaaTypeNode(members[i].second);
+        if (!field) {
+          // e.g. an array member, the accesses get no struct path then
+          fields.clear();
+          break;
+        }
+        fields.push_back(std::make_pair(field,
+                                        structType->layout->fields[i].offset));
+      }
+      if (!fields.empty()) {
+        node = builder.createTBAAStructTypeNode(structType->toString(), fields);
+      }
+      }
+      break;
+    default:
+      // accesses of arrays and functions are never tagged
+      break;
+  }
+  tbaaTypes[key] = node;
+  return node;
+}
+
+llvm::MDNode* Codegeneration::IRCreator::accessTag(
+    const Parsing::SemanticDeclarationNode type) {
+  auto node = tbaaTypeNode(type);
+  if (!node || type->type() == Semantic::Type::STRUCT) {
+    // struct copies access all members at once
+    return nullptr;
+  }
+  return llvm::MDBuilder(M.getContext()).createTBAAStructTagNode(node, node, 0);
+}
+
+llvm::MDNode* Codegeneration::IRCreator::memberAccessTag(
+    const Parsing::SemanticDeclarationNode structType, unsigned index) {
+  auto as_struct = std::static_pointer_cast<Parsing::StructDeclaration>(structType);
+  auto member = as_struct->members().at(index).second;
+  auto base = tbaaTypeNode(structType);
+  auto access = tbaaTypeNode(member);
+  if (!base || !access || member->type() == Semantic::Type::STRUCT) {
+    return accessTag(member);
+  }
+  return llvm::MDBuilder(M.getContext()).createTBAAStructTagNode(base, access,
+      as_struct->layout->fields[index].offset);
+}
+
+llvm::Value* Codegeneration::IRCreator::tagAccess(llvm::Value* access,
+                                                  llvm::MDNode* tag) {
+  if (tag && (llvm::isa<llvm::LoadInst>(access)
+              || llvm::isa<llvm::StoreInst>(access))) {
+    llvm::cast<llvm::Instruction>(access)->setMetadata(
+        llvm::LLVMContext::MD_tbaa, tag);
+  }
+  return access;
+}
+
+void Codegeneration::IRCreator::markNoAlias(llvm::Argument* argument) {
+  // attribute indices of the parameters start at 1, 0 is the return value
+  argument->addAttr(llvm::AttributeSet::get(
+      argument->getContext(), argument->getArgNo() + 1,
+      llvm::Attribute::NoAlias));
+}
+
+llvm::Type* Codegeneration::IRCreator::lower_type(
+    const Parsing::SemanticDeclarationNode semantic_type) {
   llvm::Type *llvm_type = nullptr;
   switch(semantic_type->type()){
     case Semantic::Type::INT:
@@ -761,6 +1340,15 @@ llvm::Type* Codegeneration::IRCreator::semantic_type2llvm_type(
     case Semantic::Type::CHAR:
       llvm_type = Builder.getInt8Ty();
       break;
+
+    case Semantic::Type::UNSIGNED:
+      llvm_type = Builder.getInt32Ty();
+      break;
+
+    case Semantic::Type::LONG:
+    case Semantic::Type::UNSIGNED_LONG:
+      llvm_type = Builder.getInt64Ty();
+      break;
                               
     case Semantic::Type::VOID:
       llvm_type = Builder.getVoidTy();
@@ -797,12 +1385,22 @@ llvm::Type* Codegeneration::IRCreator::semantic_type2llvm_type(
         *structType->llvm_type = struct_type;
         /* TODO: handle non primitive types*/
         std::vector<llvm::Type *> member_types;
+        auto & members = structType->members();
+        member_types.reserve(members.size());
         // TODO: use transform
-        if (structType->members().size()) {
-          for (auto member: structType->members()) {
+        if (members.size()) {
+          for (auto & member: members) {
             member_types.push_back(semantic_type2llvm_type(member.second));
           }
         struct_type->setBody(member_types);
+        // the layout is computed once per struct definition, member accesses
+        // only need the index the semantic analysis stored for them
+        auto struct_layout = DL.getStructLayout(struct_type);
+        auto & fields = structType->layout->fields;
+        fields.reserve(member_types.size());
+        for (unsigned i = 0; i < member_types.size(); ++i) {
+          fields.push_back({member_types[i], struct_layout->getElementOffset(i)});
+        }
         }
         llvm_type = struct_type;
       }
@@ -846,36 +1444,6 @@ llvm::Type* Codegeneration::IRCreator::semantic_type2llvm_type(
   return llvm_type;
 }
 
-/*
- * Given the two expression nodes, where lhs MUST be a struct or a pointer to 
- * it and rhs MUST be a variable, the function computes the correct index for 
- * the GEP pointer
- */
-int Codegeneration::IRCreator::computeIndex (Parsing::SubExpression lhs, 
-                Parsing::SubExpression rhs){
-  Parsing::SemanticDeclarationNode type = lhs->getType();
-  //It could also be a pointer based acces with ->
-  //check this
-  if(type->type() == Semantic::Type::POINTER){
-    auto pointer = std::static_pointer_cast<Parsing::PointerDeclaration> (type);
-    //save the struct type in the type field
-    type = pointer->pointee();
-  } //now we can continue
-  auto  structtype = std::static_pointer_cast<Parsing::StructDeclaration> (type);
-  auto members = structtype->members();
-  auto it = members.begin();
-  auto  rhsAsVar = std::static_pointer_cast<Parsing::VariableUsage> (rhs);
-  //our indexes start with 0 as in the example file
-  int i = 0;
-  //now compute the index with the compareTypes function
-  while (! (Semantic::compareTypes(it->second, rhs->getType())) && 
-         ! (it->first == rhsAsVar->name)){
-    ++it;
-    ++i;
-  }
-  return i;
-}
-
 /*
  * Method for easy type conversion. Argument vals type is compared to the
  * expected type. If they match, no type conversion is done. Otherwise val
@@ -896,6 +1464,34 @@ llvm::Value* Codegeneration::IRCreator::convert(
   return convert(val, llvm_type);
 }
 
+llvm::Value* Codegeneration::IRCreator::convert(
+    llvm::Value* val,
+    Parsing::SemanticDeclarationNode from,
+    Parsing::SemanticDeclarationNode to)
+{
+  auto llvm_type = semantic_type2llvm_type(to);
+  if (   val->getType() != llvm_type && Semantic::isUnsignedType(from)
+      && llvm_type->isIntegerTy()) {
+    return Builder.CreateZExtOrTrunc(val, llvm_type);
+  }
+  return convert(val, llvm_type);
+}
+
+llvm::Type* Codegeneration::IRCreator::indexType()
+{
+  return DL.getIntPtrType(M.getContext());
+}
+
+llvm::Value* Codegeneration::IRCreator::convertToIndex(
+    llvm::Value* val,
+    Parsing::SemanticDeclarationNode from)
+{
+  if (Semantic::isUnsignedType(from)) {
+    return Builder.CreateZExtOrTrunc(val, indexType());
+  }
+  return convert(val, indexType());
+}
+
 bool Codegeneration::IRCreator::isVoidPP (llvm::Type *type){
   if(type->isPointerTy())
         return this->isVoidP(type->getPointerElementType());
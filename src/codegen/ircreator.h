@@ -2,15 +2,29 @@
 #define IRCREATOR_H
 
 #include "llvm/IR/Module.h"                /* Module */
+#include "llvm/IR/DataLayout.h"            /* DataLayout */
 #include "llvm/IR/Function.h"              /* Function */
 #include "llvm/IR/Constant.h"              /* Constant::getNullValue */
 #include "llvm/IR/IRBuilder.h"             /* IRBuilder */
 #include "llvm/IR/LLVMContext.h"           /* LLVMContext */
 #include "llvm/IR/GlobalValue.h"           /* GlobaleVariable, LinkageTypes */
+#include "llvm/IR/Metadata.h"              /* MDNode */
 #include "llvm/Analysis/Verifier.h"        /* verifyFunction, verifyModule */
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/ValueHandle.h"      /* WeakVH */
+#include "llvm/Target/TargetMachine.h"     /* CodeGenFileType */
+#include "llvm/DIBuilder.h"                /* DIBuilder */
+#include "llvm/DebugInfo.h"                /* DIFile, DISubprogram */
+
+#include "cogen.h"                         /* OptLevel */
+#include "profile.h"                       /* BranchProfile */
+#include "../utils/pos.h"
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Parsing {
   class Expression;
@@ -33,29 +47,38 @@ namespace Codegeneration {
         class IRCreator {
         
                 public:
-		IRCreator(const char* filename);
+		// filename is the source file, it names the module and the compile unit
+		IRCreator(const char* filename, const Options & options = Options());
 		~IRCreator();
                 void print(llvm::raw_fd_ostream & out);
+                void writeBitcode(llvm::raw_fd_ostream & out);
+                // runs the code generator of the host's target machine
+                void emitMachineCode(llvm::raw_fd_ostream & out,
+                                llvm::TargetMachine::CodeGenFileType type);
+                // executes main with the JIT, see Codegeneration::runLLVMIR
+                int run(const std::vector<std::string> & arguments);
                 // expressions
 		BINEXPCREATE(createAdd)
                 BINEXPCREATE(createPAdd)
 		BINEXPCREATE(createMinus)
                 BINEXPCREATE(createPMinus)
                 BINEXPCREATE(createPPMinus)
-		BINEXPCREATE(createLess)
+                // unsigned compares the operands as unsigned integers
+		llvm::Value* createLess(llvm::Value* lhs, llvm::Value* rhs,
+                                bool isUnsigned = false);
 		BINEXPCREATE(createMult)
 		BINEXPCREATE(createUnequal)
 		BINEXPCREATE(createEqual)
-		BINEXPCREATE(createLogAnd)
-		BINEXPCREATE(createLogOr)
                 BINEXPCREATE(createArrayAccess)
 		llvm::Value* createAssign(llvm::Value* lhs, llvm::Value* rhs,
-                                llvm::Type* type);
+                                llvm::Type* type, llvm::MDNode* tag = nullptr);
 		BINEXPCRIND(createPointerAccess)
 		BINEXPCRIND(createAccess)
                 BINEXPCRIND(getAddressfromPointer)
                 BINEXPCRIND(getMemberAddress)
                 BINEXPCRIND(getArrayPosition)
+                // ! yields the int 0 or 1, for operands of any width; && and
+                // || short circuit, so they are emitted as branches and a phi
                 UNEXPCREATE(createLogNeg)
                 UNEXPCREATE(createNeg)
                 UNEXPCREATE(createDeref)
@@ -65,6 +88,7 @@ namespace Codegeneration {
                 ALLOC(allocLiteral)
                 llvm::Value* allocChar(char val);
                 llvm::Value* allocInt ( int val);
+                llvm::Value* allocLong(long long val);
                 llvm::Value* allocNullptr(llvm::Type*);
                 llvm::Value* createFCall(llvm::Value* func, 
                                 std::vector<llvm::Value*> params, 
@@ -72,12 +96,13 @@ namespace Codegeneration {
                 // controlflow
                 llvm::BasicBlock* getControlFlowBlock();
                 void setCurrentBasicBlock(llvm::BasicBlock*);
-                llvm::Value* makeSelect(Parsing::SubExpression cond, 
-                                Parsing::SubExpression lhs, 
-                                Parsing::SubExpression rhs);
-                llvm::Value* makeSelectLV(Parsing::SubExpression cond, 
-                                Parsing::SubExpression lhs, 
-                                Parsing::SubExpression rhs);
+                // chooses consequence if condition is not zero, without
+                // branching; both values must have the same type
+                llvm::Value* makeSelect(llvm::Value* condition,
+                                llvm::Value* consequence,
+                                llvm::Value* alternative);
+                // like makeBreak, makeContinue and makeJump, leaves the
+                // current block, so that the code after it is unreachable
                 void makeReturn(llvm::Value *value);
                 // creates a new basic block for the if head and set an insert
                 // point into it
@@ -87,17 +112,32 @@ namespace Codegeneration {
                 // create a block 
                 // connected : true -> begins with follow block
                 // connected : false -> is independent block
+                // a connected block is entered even if the current code is
+                // unreachable, it has no predecessors then
                 llvm::BasicBlock* makeBlock(std::string labelName, bool connect = true);
 
                 // adds an unconditional jump from "from" to "to"
-                // and returns from
+                // and returns from; a null from is the current block, no
+                // jump is added if the current code is unreachable
                 llvm::BasicBlock* connect(llvm::BasicBlock *from, llvm::BasicBlock *to);
                 void connect(llvm::BasicBlock *to);
+                // jumps to "to" and leaves the current block
+                void makeJump(llvm::BasicBlock *to);
+                /* false after a return or jump, until a block is entered
+                 * again; nothing may be emitted then, except declarations */
+                bool isReachable();
+                /* Enters the sealed block if it has a predecessor, otherwise
+                 * the block is removed and the code stays unreachable;
+                 * returns whether the block was entered */
+                bool enterIfReachable(llvm::BasicBlock* block);
                 void makeConditonalBranch(
                     llvm::Value* branchCondition,
                     llvm::BasicBlock* consequenceBlock,
                     llvm::BasicBlock* alternativeBlock
                 );
+                /* Tags the back edge of a loop, the terminator of its only
+                 * latch, with a new llvm.loop node carrying the loop hints */
+                void markLoop(llvm::BasicBlock* latch);
                 llvm::Value* makePhi(
                     llvm::BasicBlock* consequenceBlock,
                     llvm::Value* consequenceValue,
@@ -107,17 +147,50 @@ namespace Codegeneration {
                 // utilities
                 llvm::Type* semantic_type2llvm_type(
                     const Parsing::SemanticDeclarationNode semantic_type);
+                // type based alias analysis
+                /* The tag for a load or store of an object of type, or of
+                 * the member index of a struct; nullptr if the access may
+                 * alias anything, e.g. because TBAA is disabled */
+                llvm::MDNode* accessTag(const Parsing::SemanticDeclarationNode type);
+                llvm::MDNode* memberAccessTag(
+                    const Parsing::SemanticDeclarationNode structType,
+                    unsigned index);
+                // attaches tag to the load or store access and returns it
+                llvm::Value* tagAccess(llvm::Value* access, llvm::MDNode* tag);
+                // promises that argument is the only way the function
+                // accesses the objects it points to, as restrict does
+                void markNoAlias(llvm::Argument* argument);
                 llvm::Value* allocateInCurrentFunction(llvm::Type* type);
-                void store(llvm::Value* value, llvm::Value *ptr);
+                // local variables in SSA form
+                /* true for scalars whose address is never taken; they get
+                 * no stack slot, but are kept in SSA values directly */
+                bool canPromote(const Parsing::SemanticDeclarationNode variable);
+                void declareVariable(const Parsing::SemanticDeclarationNode variable,
+                                llvm::Type* type, std::string name);
+                void declareVariable(const Parsing::SemanticDeclarationNode variable,
+                                llvm::Value* initialValue, std::string name);
+                bool isSSAVariable(const Parsing::SemanticDeclarationNode variable);
+                llvm::Value* readVariable(const Parsing::SemanticDeclarationNode variable);
+                llvm::Value* assignVariable(const Parsing::SemanticDeclarationNode variable,
+                                llvm::Value* rhs, llvm::Type* type);
+                /* Declares that all predecessors of block are known; must not
+                 * be called before the last branch to block was created.
+                 * Blocks which are never sealed explicitly (e.g. labels) are
+                 * sealed by finishFunction */
+                void sealBlock(llvm::BasicBlock* block);
+                void store(llvm::Value* value, llvm::Value *ptr,
+                                llvm::MDNode* tag = nullptr);
                 llvm::Value* createLoad(llvm::Value* val);
                 // functions
                 /* Allocates a basic block for a functions,
-                 * and sets the Builder to it
+                 * and sets the Builder to it; internal functions are only
+                 * visible inside the module
                  */
                 llvm::Function *startFunction(
                     llvm::FunctionType* function_type,
                     std::string name,
-                    bool definition=true
+                    bool definition=true,
+                    bool internal=false
                     );
                 llvm::Function *startAlreadyDefinedFunction(
                     llvm::Function* function,
@@ -127,15 +200,33 @@ namespace Codegeneration {
                 
                 void setCurrentBreakPoint(llvm::BasicBlock* block);
                 void setCurrentContinuePoint(llvm::BasicBlock* block);
+                llvm::BasicBlock* getCurrentBreakPoint();
+                llvm::BasicBlock* getCurrentContinuePoint();
+                // switch statements
+                /* Jumps to the case matching value, or to defaultBlock until
+                 * a default label is added; leaves the current block */
+                llvm::SwitchInst* makeSwitch(llvm::Value* value,
+                                llvm::BasicBlock* defaultBlock);
+                // a null value adds the default label
+                void addSwitchLabel(llvm::SwitchInst* switchInst,
+                                llvm::ConstantInt* value, llvm::BasicBlock* block);
+                llvm::ConstantInt* makeCaseValue(llvm::SwitchInst* switchInst,
+                                int value);
+                void setCurrentSwitch(llvm::SwitchInst* switchInst);
+                llvm::SwitchInst* getCurrentSwitch();
 
 
                 /* Ensures that the last block of the function has a terminator
                  */
                 void finishFunction();
+                // debug information, only emitted with Options::debugInfo
+                // describes the function defined at pos
+                void describeFunction(llvm::Function* function, const Pos & pos);
+                // the instructions emitted from now on stem from pos
+                void setDebugLocation(const Pos & pos);
                 // declarations
-                llvm::GlobalVariable *makeGlobVar(llvm::Type *type);
-                int computeIndex (Parsing::SubExpression lhs,
-                               Parsing::SubExpression rhs);
+                llvm::GlobalVariable *makeGlobVar(llvm::Type *type,
+                                                  bool internal = false);
 
                 void makeBreak();
                 void makeContinue();
@@ -148,22 +239,105 @@ namespace Codegeneration {
                 //Method to do type conversion if necessary
                 llvm::Value* convert(llvm::Value*, llvm::Type*);
                 llvm::Value* convert(llvm::Value*, Parsing::SemanticDeclarationNode);
+                /* Converts a value of the semantic type from to the type to;
+                 * integers are extended with their sign, unless from is an
+                 * unsigned type */
+                llvm::Value* convert(llvm::Value*,
+                                Parsing::SemanticDeclarationNode from,
+                                Parsing::SemanticDeclarationNode to);
+                // the integer type of pointer width, used for GEP indices
+                llvm::Type* indexType();
+                // converts an integer of the semantic type from to indexType()
+                llvm::Value* convertToIndex(llvm::Value*,
+                                Parsing::SemanticDeclarationNode from);
 
-                void optimize();
+                /* Completes the module after the last function, e.g. with
+                 * the counters of the instrumentation */
+                void finishModule();
+                // runs the pipeline of the options' level, in parallel if
+                // they ask for more than one worker
+                void optimize(const Options & options);
+                // prints hit/miss counters of the type lowering cache
+                void printStatistics(llvm::raw_ostream & out);
 
                 //type field to quickly modify our "usual arithmetic 
                 //conversions" type
                 llvm::Type* USUALTYPE;
 	private:
+                // compares value against zero
+                llvm::Value* isNonZero(llvm::Value* value);
+                // sign extends integers narrower than USUALTYPE to it
+                llvm::Value* promote(llvm::Value* value);
                 bool isVoidPP(llvm::Type* type);
                 bool isVoidP(llvm::Type* type);
+                llvm::Type* lower_type(
+                    const Parsing::SemanticDeclarationNode semantic_type);
+                /* The node of type in the TBAA type tree: char is the root
+                 * all other types may alias, int and pointers are scalars
+                 * below it, structs list their fields with offsets */
+                llvm::MDNode* tbaaTypeNode(
+                    const Parsing::SemanticDeclarationNode type);
+                // SSA construction, see Braun et al., "Simple and Efficient
+                // Construction of Static Single Assignment Form", CC 2013
+                typedef Parsing::SemanticDeclaration* Variable;
+                void writeVariable(Variable variable, llvm::BasicBlock* block,
+                                llvm::Value* value);
+                llvm::Value* readVariable(Variable variable, llvm::BasicBlock* block);
+                llvm::Value* readVariableRecursive(Variable variable,
+                                llvm::BasicBlock* block);
+                llvm::PHINode* createPhi(Variable variable, llvm::BasicBlock* block);
+                llvm::Value* addPhiOperands(Variable variable, llvm::PHINode* phi);
+                llvm::Value* tryRemoveTrivialPhi(llvm::PHINode* phi);
 
 		llvm::Module M;
+		llvm::DataLayout DL;
 		llvm::IRBuilder<> Builder, AllocaBuilder;
                 llvm::Function* currentFunction;
                 llvm::BasicBlock* currentBreakPoint;
                 llvm::BasicBlock* currentContinuePoint;
+                llvm::SwitchInst* currentSwitch;
                 std::map<std::string, llvm::BasicBlock* > mapLabel;
+                // lowered types, keyed by the canonical semantic type
+                std::unordered_map<Parsing::SemanticDeclaration*, llvm::Type*> loweredTypes;
+                bool useTBAA;
+                // created with the first type node
+                llvm::MDNode* tbaaChar;
+                // TBAA type nodes, keyed by the canonical semantic type
+                std::unordered_map<Parsing::SemanticDeclaration*, llvm::MDNode*> tbaaTypes;
+                std::unique_ptr<llvm::DIBuilder> debugInfo;
+                bool optimized;
+                llvm::DIFile debugFile;
+                // the scope of the debug locations, null outside of functions
+                llvm::MDNode* debugScope;
+                // profiling, see profile.h
+                bool instrument;
+                std::string profileOutput;
+                // stands in for the counter array until its size is known
+                llvm::GlobalVariable* profileCounters;
+                std::vector<BranchId> profileBranches;
+                std::unique_ptr<BranchProfile> profile;
+                // conditional branches of the current function so far
+                unsigned branchesInFunction;
+                // loop hints, see Options
+                unsigned unrollCount;
+                bool vectorize;
+                // one constant per distinct string literal, keyed by its bytes
+                std::unordered_map<std::string, llvm::Constant*> stringLiterals;
+                struct SSAVariable {
+                  llvm::Type* type;
+                  std::string name;
+                };
+                // state of the SSA construction, reset by finishFunction
+                std::unordered_map<Variable, SSAVariable> ssaVariables;
+                // the value handles follow replaceAllUsesWith, so removing
+                // a trivial phi also updates the definitions referring to it
+                std::unordered_map<llvm::BasicBlock*,
+                  std::unordered_map<Variable, llvm::WeakVH>> currentDef;
+                std::unordered_map<llvm::BasicBlock*,
+                  std::vector<std::pair<Variable, llvm::PHINode*>>> incompletePhis;
+                std::unordered_set<llvm::BasicBlock*> sealedBlocks;
+                unsigned long typeCacheHits;
+                unsigned long typeCacheMisses;
   };
 }
 #endif
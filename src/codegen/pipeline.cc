@@ -0,0 +1,392 @@
+#include "pipeline.h"
+#include "sccp_pass.h"
+
+#include "llvm/IR/Module.h"                /* Module */
+#include "llvm/IR/LLVMContext.h"           /* LLVMContext */
+#include "llvm/IR/DataLayout.h"            /* DataLayout */
+#include "llvm/IR/Instructions.h"          /* LoadInst */
+#include "llvm/PassManager.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/IPO.h"           /* createFunctionInliningPass */
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Support/TargetRegistry.h"   /* TargetRegistry::lookupTarget */
+#include "llvm/Support/TargetSelect.h"     /* InitializeNativeTarget */
+#include "llvm/Support/Host.h"             /* getHostCPUName */
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"        /* llvm_start_multithreaded */
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Bitcode/ReaderWriter.h"     /* WriteBitcodeToFile, ParseBitcodeFile */
+#include "llvm/Linker.h"                   /* Linker::LinkModules */
+#include "llvm/ADT/Triple.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void addSCCPPass(const llvm::PassManagerBuilder &, llvm::PassManagerBase & PM)
+{
+  PM.add(new SCCP_Pass());
+}
+
+// the level of LLVM's pipelines, 0 for -O0 and --optimize
+unsigned builderOptLevel(const Codegeneration::Options & options)
+{
+  using Codegeneration::OptLevel;
+  switch (options.optLevel) {
+    case OptLevel::O1:
+      return 1;
+    case OptLevel::O2:
+      return 2;
+    case OptLevel::O3:
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+// thresholds as used by clang; -O1 only inlines always_inline functions
+llvm::Pass* createInliner(unsigned optLevel)
+{
+  return (optLevel > 1)
+    ? llvm::createFunctionInliningPass(optLevel > 2 ? 275 : 225)
+    : llvm::createAlwaysInlinerPass();
+}
+
+/*
+ * -O1 to -O3 use the standard pipelines of LLVM, tuned for the host. Our
+ * SCCP_Pass runs at the end of the scalar optimizations, after GVN,
+ * MemCpyOpt and LLVM's own SCCP have simplified the function; the
+ * aggressive dead code elimination and CFG simplification that follow
+ * remove what it folds away.
+ *
+ * The loop hints of the options are also attached to the loops as llvm.loop
+ * metadata, but our LLVM does not read the unroll count from there yet, so
+ * the pipeline applies them itself.
+ */
+void runPipeline(llvm::Module & module, const Codegeneration::Options & options,
+                 bool inlining)
+{
+  using Codegeneration::OptLevel;
+  if (options.optLevel == OptLevel::O0) {
+    return;
+  }
+  if (options.optLevel == OptLevel::SCCP) {
+    llvm::PassManager PM;
+    PM.add(llvm::createPromoteMemoryToRegisterPass());
+    PM.add(new SCCP_Pass());
+    PM.run(module);
+    return;
+  }
+  auto optLevel = builderOptLevel(options);
+
+  auto machine = Codegeneration::createHostTargetMachine(module);
+  llvm::PassManagerBuilder builder;
+  builder.OptLevel = optLevel;
+  builder.SizeLevel = 0;
+  if (inlining) {
+    builder.Inliner = createInliner(optLevel);
+  }
+  // an explicit unroll count replaces the unrolling of the pipeline
+  builder.DisableUnrollLoops = optLevel < 2 || options.unrollCount > 0;
+  builder.LoopVectorize = optLevel > 1 || options.vectorize;
+  builder.SLPVectorize = optLevel > 2;
+  builder.LibraryInfo = new llvm::TargetLibraryInfo(
+      llvm::Triple(module.getTargetTriple()));
+  builder.addExtension(llvm::PassManagerBuilder::EP_ScalarOptimizerLate,
+                       addSCCPPass);
+
+  llvm::FunctionPassManager FPM(&module);
+  FPM.add(new llvm::DataLayout(&module));
+  machine->addAnalysisPasses(FPM);
+  builder.populateFunctionPassManager(FPM);
+
+  llvm::PassManager MPM;
+  MPM.add(new llvm::DataLayout(&module));
+  machine->addAnalysisPasses(MPM);
+  builder.populateModulePassManager(MPM);
+  if (options.unrollCount > 0) {
+    // after the vectorizer, which would otherwise see unrolled loops
+    MPM.add(llvm::createLoopUnrollPass(-1, options.unrollCount, 1));
+    MPM.add(llvm::createInstructionCombiningPass());
+    MPM.add(llvm::createCFGSimplificationPass());
+  }
+
+  FPM.doInitialization();
+  for (auto & function : module) {
+    FPM.run(function);
+  }
+  FPM.doFinalization();
+  MPM.run(module);
+}
+
+/*
+ * The part of the pipeline which needs to see the whole module with its
+ * internal symbols, before optimizeFunctionsInParallel splits it: the
+ * interprocedural passes at the start of LLVM's module pipeline, followed by
+ * the inliner and the removal of the functions and globals which are dead
+ * then. --optimize has no such passes, but SCCP_Pass folds the loads of
+ * globals which always hold their initializer; the partitions only see
+ * declarations of the globals, so those loads are folded here.
+ */
+void runInterproceduralPasses(llvm::Module & module,
+                              const Codegeneration::Options & options)
+{
+  if (options.optLevel == Codegeneration::OptLevel::SCCP) {
+    for (auto global = module.global_begin(); global != module.global_end();
+         ++global) {
+      if (!holdsInitializer(*global)) {
+        continue;
+      }
+      std::vector<llvm::LoadInst*> loads;
+      for (auto use = global->use_begin(); use != global->use_end(); ++use) {
+        if (auto load = llvm::dyn_cast<llvm::LoadInst>(*use)) {
+          loads.push_back(load);
+        }
+      }
+      for (auto load : loads) {
+        load->replaceAllUsesWith(global->getInitializer());
+        load->eraseFromParent();
+      }
+    }
+    return;
+  }
+  auto optLevel = builderOptLevel(options);
+  auto machine = Codegeneration::createHostTargetMachine(module);
+  llvm::PassManager MPM;
+  MPM.add(new llvm::DataLayout(&module));
+  machine->addAnalysisPasses(MPM);
+  MPM.add(new llvm::TargetLibraryInfo(llvm::Triple(module.getTargetTriple())));
+  MPM.add(llvm::createIPSCCPPass());
+  MPM.add(llvm::createGlobalOptimizerPass());
+  MPM.add(llvm::createDeadArgEliminationPass());
+  MPM.add(llvm::createInstructionCombiningPass());
+  MPM.add(llvm::createCFGSimplificationPass());
+  MPM.add(createInliner(optLevel));
+  MPM.add(llvm::createGlobalDCEPass());
+  MPM.add(llvm::createConstantMergePass());
+  MPM.run(module);
+}
+
+std::string writeBitcode(llvm::Module & module)
+{
+  std::string bitcode;
+  llvm::raw_string_ostream stream(bitcode);
+  llvm::WriteBitcodeToFile(&module, stream);
+  stream.flush();
+  return bitcode;
+}
+
+std::unique_ptr<llvm::Module> readBitcode(const std::string & bitcode,
+                                          llvm::LLVMContext & context)
+{
+  std::unique_ptr<llvm::MemoryBuffer> buffer(
+      llvm::MemoryBuffer::getMemBuffer(bitcode, "", false));
+  std::string error;
+  std::unique_ptr<llvm::Module> module(
+      llvm::ParseBitcodeFile(buffer.get(), context, &error));
+  if (!module) {
+    throw std::runtime_error("cannot read a partition: " + error);
+  }
+  return module;
+}
+
+/*
+ * Turns all function definitions of module which do not belong to the
+ * partition into declarations. Global variables are defined by the module
+ * the partitions are linked into, so they become declarations as well;
+ * constants stay visible to the optimizer as available_externally. Appending
+ * globals like llvm.global_dtors are kept by that module alone, and so is the
+ * debug compile unit, which already lists the functions of all partitions.
+ */
+void restrictToPartition(llvm::Module & module,
+                         const std::unordered_set<std::string> & partition)
+{
+  for (auto & function : module) {
+    if (!function.isDeclaration() && !partition.count(function.getName())) {
+      function.deleteBody();
+    }
+  }
+  for (auto global = module.global_begin(); global != module.global_end();) {
+    if (global->hasAppendingLinkage()) {
+      (global++)->eraseFromParent();
+      continue;
+    }
+    if (global->isDeclaration()) {
+      ++global;
+      continue;
+    }
+    if (global->isConstant()) {
+      global->setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+    } else {
+      global->setInitializer(nullptr);
+      global->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+    ++global;
+  }
+  if (auto units = module.getNamedMetadata("llvm.dbg.cu")) {
+    module.eraseNamedMetadata(units);
+  }
+}
+
+size_t instructionCount(llvm::Function & function)
+{
+  size_t count = 0;
+  for (auto & block : function) {
+    count += block.size();
+  }
+  return count;
+}
+
+}
+
+std::unique_ptr<llvm::TargetMachine>
+Codegeneration::createHostTargetMachine(llvm::Module & module)
+{
+  static std::once_flag initialized;
+  std::call_once(initialized, []() {
+      llvm::InitializeNativeTarget();
+      llvm::InitializeNativeTargetAsmPrinter();
+  });
+  // the triple was set to the host's one by the IRCreator
+  std::string error;
+  auto triple = module.getTargetTriple();
+  auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+  if (!target) {
+    throw std::runtime_error(error);
+  }
+  llvm::TargetOptions targetOptions;
+  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+      triple, llvm::sys::getHostCPUName(), "", targetOptions));
+  module.setDataLayout(machine->getDataLayout()->getStringRepresentation());
+  return machine;
+}
+
+void Codegeneration::optimizeModule(llvm::Module & module,
+                                    const Options & options)
+{
+  runPipeline(module, options, true);
+}
+
+void Codegeneration::optimizeFunctionsInParallel(llvm::Module & module,
+    const Options & options)
+{
+  if (options.optLevel == OptLevel::O0) {
+    return;
+  }
+  runInterproceduralPasses(module, options);
+  auto workers = options.optimizationWorkers;
+  std::vector<llvm::Function*> functions;
+  for (auto & function : module) {
+    if (!function.isDeclaration()) {
+      functions.push_back(&function);
+    }
+  }
+  workers = std::min<size_t>(workers, functions.size());
+  if (workers < 2) {
+    optimizeModule(module, options);
+    return;
+  }
+
+  // balance the partitions: the largest functions go first, each of them to
+  // the partition with the fewest instructions so far
+  std::vector<std::pair<size_t, llvm::Function*>> bySize;
+  for (auto function : functions) {
+    bySize.push_back(std::make_pair(instructionCount(*function), function));
+  }
+  std::stable_sort(bySize.begin(), bySize.end(),
+      [](const std::pair<size_t, llvm::Function*> & a,
+         const std::pair<size_t, llvm::Function*> & b) {
+        return a.first > b.first;
+      });
+  std::vector<std::unordered_set<std::string>> partitions(workers);
+  std::vector<size_t> load(workers, 0);
+  for (auto & function : bySize) {
+    auto lightest = std::min_element(load.begin(), load.end()) - load.begin();
+    partitions[lightest].insert(function.second->getName());
+    load[lightest] += function.first;
+  }
+
+  // the partitions refer to each other's symbols by name, so local symbols
+  // are made external until the partitions have been linked back
+  std::vector<std::pair<std::string, llvm::GlobalValue::LinkageTypes>> localSymbols;
+  auto makeExternal = [&](llvm::GlobalValue & value) {
+    if (!value.hasLocalLinkage()) {
+      return;
+    }
+    if (!value.hasName()) {
+      value.setName("c4.local");
+    }
+    localSymbols.push_back(std::make_pair(value.getName().str(),
+                                          value.getLinkage()));
+    value.setLinkage(llvm::GlobalValue::ExternalLinkage);
+  };
+  for (auto global = module.global_begin(); global != module.global_end();
+       ++global) {
+    makeExternal(*global);
+  }
+  for (auto & function : module) {
+    makeExternal(function);
+  }
+
+  auto bitcode = writeBitcode(module);
+  llvm::llvm_start_multithreaded();
+  std::vector<std::string> results(workers);
+  std::vector<std::exception_ptr> errors(workers);
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < workers; i = next++) {
+      try {
+        llvm::LLVMContext context;
+        auto partition = readBitcode(bitcode, context);
+        restrictToPartition(*partition, partitions[i]);
+        runPipeline(*partition, options, false);
+        results[i] = writeBitcode(*partition);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // the optimized bodies replace the original ones
+  for (auto function : functions) {
+    function->deleteBody();
+  }
+  for (auto & result : results) {
+    auto partition = readBitcode(result, module.getContext());
+    std::string error;
+    if (llvm::Linker::LinkModules(&module, partition.get(),
+                                  llvm::Linker::DestroySource, &error)) {
+      throw std::runtime_error("cannot link a partition: " + error);
+    }
+  }
+  for (auto & symbol : localSymbols) {
+    if (auto value = module.getNamedValue(symbol.first)) {
+      value->setLinkage(symbol.second);
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef CODEGEN_PIPELINE_H
+#define CODEGEN_PIPELINE_H
+#pragma once
+
+#include "cogen.h"                         /* Options */
+
+#include <memory>
+
+namespace llvm {
+  class Module;
+  class TargetMachine;
+}
+
+namespace Codegeneration {
+
+  /* Creates a target machine for the host triple of module and sets the data
+   * layout of module to the one of the machine */
+  std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(llvm::Module & module);
+
+  /* Runs the pass pipeline of the options' level over module */
+  void optimizeModule(llvm::Module & module, const Options & options);
+
+  /*
+   * Like optimizeModule, but the functions are split into one partition per
+   * worker of options. Each partition is optimized in its own LLVMContext on its own
+   * thread, afterwards the partitions are linked back into module.
+   *
+   * The inliner and the interprocedural passes first run serially on the
+   * whole module, so they see the same module as without partitions; only
+   * the repetitions of them in the partitions' pipelines see the functions
+   * of other partitions as declarations.
+   */
+  void optimizeFunctionsInParallel(llvm::Module & module,
+                                   const Options & options);
+}
+
+#endif
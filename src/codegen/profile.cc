@@ -0,0 +1,164 @@
+#include "profile.h"
+
+#include "llvm/IR/Module.h"                /* Module */
+#include "llvm/IR/Function.h"              /* Function */
+#include "llvm/IR/GlobalVariable.h"        /* GlobalVariable */
+#include "llvm/IR/IRBuilder.h"             /* IRBuilder */
+#include "llvm/IR/LLVMContext.h"           /* LLVMContext */
+#include "llvm/IR/MDBuilder.h"             /* MDBuilder */
+#include "llvm/Transforms/Utils/ModuleUtils.h" /* appendToGlobalDtors */
+#include "../utils/diagnostic.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+/*
+ * A profile is a text file: a header line, followed by one line per branch
+ * with the name of the module, the name of the function, the number of the
+ * branch in it and how often the condition was true and false. Every module of the program
+ * appends such a section when the program exits, and so does every run.
+ */
+static const char* const PROFILE_HEADER = "c4-profile 2";
+
+Codegeneration::BranchProfile::BranchProfile(const std::string & file)
+{
+  std::ifstream in(file);
+  std::string header;
+  if (!std::getline(in, header)) {
+    throw std::runtime_error("cannot read the profile " + file);
+  }
+  if (header != PROFILE_HEADER) {
+    throw std::runtime_error(file + " is not a profile written by c4");
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line == PROFILE_HEADER) {
+      continue;
+    }
+    std::istringstream fields(line);
+    BranchId branch;
+    BranchCounts branchCounts;
+    if (!(fields >> branch.module >> branch.function >> branch.index
+                 >> branchCounts.taken >> branchCounts.notTaken)) {
+      throw std::runtime_error("the profile " + file + " is malformed");
+    }
+    auto & total = counts[branch];
+    total.taken += branchCounts.taken;
+    total.notTaken += branchCounts.notTaken;
+  }
+}
+
+const Codegeneration::BranchCounts* Codegeneration::BranchProfile::find(
+    const BranchId & branch) const
+{
+  auto counts = this->counts.find(branch);
+  return (counts == this->counts.end()) ? nullptr : &counts->second;
+}
+
+llvm::MDNode* Codegeneration::branchWeights(llvm::LLVMContext & context,
+                                            const BranchCounts & counts)
+{
+  // keep the ratio, but leave room for the + 1
+  uint64_t limit = std::numeric_limits<uint32_t>::max() - 1;
+  auto scale = std::max(counts.taken, counts.notTaken) / limit + 1;
+  // a weight of 0 would mean that the edge is never taken at all
+  return llvm::MDBuilder(context).createBranchWeights(
+      counts.taken / scale + 1, counts.notTaken / scale + 1);
+}
+
+/*
+ * The function of the C library called name, or nullptr if the program
+ * defines a function of that name itself or declares it with another type;
+ * the writer would call the wrong function then
+ */
+static llvm::Constant* libraryFunction(llvm::Module & module,
+                                       const char* name,
+                                       llvm::FunctionType* type)
+{
+  auto existing = module.getNamedValue(name);
+  auto function = llvm::dyn_cast_or_null<llvm::Function>(existing);
+  if (existing && (!function || !function->isDeclaration()
+                   || function->getFunctionType() != type)) {
+    errorf(Pos(module.getModuleIdentifier().c_str()),
+           "--instrument calls %s of the C library, which this file "
+           "defines or declares differently", name);
+    return nullptr;
+  }
+  return module.getOrInsertFunction(name, type);
+}
+
+void Codegeneration::emitProfileWriter(llvm::Module & module,
+    llvm::GlobalVariable* counters, const std::vector<BranchId> & branches,
+    const std::string & file)
+{
+  auto & context = module.getContext();
+  llvm::IRBuilder<> builder(context);
+  auto bytePtr = builder.getInt8PtrTy();
+  // FILE* is passed as i8*
+  llvm::Type* openParams[] = {bytePtr, bytePtr};
+  auto fopen = libraryFunction(module, "fopen",
+      llvm::FunctionType::get(bytePtr, openParams, false));
+  auto fprintf = libraryFunction(module, "fprintf",
+      llvm::FunctionType::get(builder.getInt32Ty(), openParams, true));
+  llvm::Type* closeParams[] = {bytePtr};
+  auto fclose = libraryFunction(module, "fclose",
+      llvm::FunctionType::get(builder.getInt32Ty(), closeParams, false));
+  if (!fopen || !fprintf || !fclose) {
+    return;
+  }
+
+  auto writer = llvm::Function::Create(
+      llvm::FunctionType::get(builder.getVoidTy(), false),
+      llvm::GlobalValue::InternalLinkage, "c4.profile.write", &module);
+  auto entry = llvm::BasicBlock::Create(context, "entry", writer);
+  auto write = llvm::BasicBlock::Create(context, "write", writer);
+  auto end = llvm::BasicBlock::Create(context, "end", writer);
+
+  builder.SetInsertPoint(entry);
+  llvm::Value* openArgs[] = {
+    builder.CreateGlobalStringPtr(file),
+    // the other modules of the program write to the same file
+    builder.CreateGlobalStringPtr("a"),
+  };
+  auto stream = builder.CreateCall(fopen, openArgs);
+  // the program must not fail because of its profile
+  builder.CreateCondBr(builder.CreateIsNull(stream), end, write);
+
+  builder.SetInsertPoint(write);
+  llvm::Value* headerArgs[] = {
+    stream,
+    builder.CreateGlobalStringPtr(std::string(PROFILE_HEADER) + "\n"),
+  };
+  builder.CreateCall(fprintf, headerArgs);
+  auto format = builder.CreateGlobalStringPtr("%s %s %u %llu %llu\n");
+  std::map<std::string, llvm::Value*> names;
+  auto nameString = [&](const std::string & name) {
+    auto & value = names[name];
+    if (!value) {
+      value = builder.CreateGlobalStringPtr(name);
+    }
+    return value;
+  };
+  for (size_t i = 0; i < branches.size(); ++i) {
+    llvm::Value* lineArgs[] = {
+      stream,
+      format,
+      nameString(branches[i].module),
+      nameString(branches[i].function),
+      builder.getInt32(branches[i].index),
+      builder.CreateLoad(builder.CreateConstInBoundsGEP2_64(counters, 0, 2*i)),
+      builder.CreateLoad(builder.CreateConstInBoundsGEP2_64(counters, 0, 2*i + 1)),
+    };
+    builder.CreateCall(fprintf, lineArgs);
+  }
+  builder.CreateCall(fclose, stream);
+  builder.CreateBr(end);
+
+  builder.SetInsertPoint(end);
+  builder.CreateRetVoid();
+  // destructors run when main returns or exit is called
+  llvm::appendToGlobalDtors(module, writer, 65535);
+}
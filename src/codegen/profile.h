@@ -0,0 +1,74 @@
+#ifndef CODEGEN_PROFILE_H
+#define CODEGEN_PROFILE_H
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace llvm {
+  class GlobalVariable;
+  class LLVMContext;
+  class MDNode;
+  class Module;
+}
+
+namespace Codegeneration {
+
+  /* A conditional branch, identified by its module, its function and by its
+   * position among the conditional branches the IRCreator emitted for the
+   * function. The module keeps static functions of the same name in
+   * different files apart. The numbering does not depend on the options, so
+   * the branches of an instrumented and of an optimized build of the same
+   * source agree. */
+  struct BranchId {
+    // the file name of the module, without its directories, so the profile
+    // stays valid if the sources move
+    std::string module;
+    std::string function;
+    unsigned index;
+
+    bool operator<(const BranchId & other) const
+    {
+      return std::tie(module, function, index)
+        < std::tie(other.module, other.function, other.index);
+    }
+  };
+
+  struct BranchCounts {
+    uint64_t taken = 0;    // the condition was true
+    uint64_t notTaken = 0;
+  };
+
+  /* The counts an instrumented program wrote when it exited, summed over
+   * all of its modules and all runs which appended to the file */
+  class BranchProfile {
+    public:
+      /* throws std::runtime_error if file cannot be read */
+      explicit BranchProfile(const std::string & file);
+      // nullptr for branches which are not in the profile
+      const BranchCounts* find(const BranchId & branch) const;
+
+    private:
+      std::map<BranchId, BranchCounts> counts;
+  };
+
+  /* The !prof metadata for a branch with counts; the weights are scaled down
+   * to 32 bits and are never 0 */
+  llvm::MDNode* branchWeights(llvm::LLVMContext & context,
+                              const BranchCounts & counts);
+
+  /*
+   * Adds a destructor to module which appends the counters to file when the
+   * program exits, in the format read by BranchProfile. counters is an array
+   * of two i64 per branch, the first one counts the true edge. Reports an
+   * error if the module has its own fopen, fprintf or fclose.
+   */
+  void emitProfileWriter(llvm::Module & module, llvm::GlobalVariable* counters,
+                         const std::vector<BranchId> & branches,
+                         const std::string & file);
+}
+
+#endif
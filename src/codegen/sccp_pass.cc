@@ -7,6 +7,8 @@
 #include "llvm/Pass.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/raw_ostream.h"
 #include "../utils/exception.h"
@@ -29,6 +31,36 @@
 
 using namespace llvm;
 
+/*
+ * A global always holds its initializer if no other module can access it, its
+ * address does not escape and all stores to it store the initializer again.
+ * Only int globals are considered, as folded values are emitted as i32.
+ */
+bool holdsInitializer(llvm::GlobalVariable& global)
+{
+  if (!global.hasLocalLinkage() || !global.hasDefinitiveInitializer()
+      || !global.getType()->getElementType()->isIntegerTy(32)
+      || !isa<ConstantInt>(global.getInitializer())) {
+    return false;
+  }
+  for (auto use = global.use_begin(); use != global.use_end(); ++use) {
+    if (auto load = dyn_cast<LoadInst>(*use)) {
+      if (load->isVolatile()) {
+        return false;
+      }
+    } else if (auto store = dyn_cast<StoreInst>(*use)) {
+      if (store->getPointerOperand() != &global
+          || store->getValueOperand() != global.getInitializer()) {
+        return false;
+      }
+    } else {
+      // the address escapes, e.g. into a GEP, a call or a constant expression
+      return false;
+    }
+  }
+  return true;
+}
+
 void ConstantTable::checkedInsert(std::pair<llvm::Value*, ConstantLattice> pair)
 {
   auto it =  this->find(pair.first);
@@ -81,6 +113,15 @@ void BlockTable::checkedInsert(std::pair<llvm::BasicBlock*, Reachability> pair)
 }
 
 
+/*
+ * The lattice holds ints, so integers wider than 32 bits, e.g. longs, are not
+ * tracked but always overdefined
+ */
+static bool tracksType(llvm::Type* type)
+{
+  return !type->isIntegerTy() || type->getIntegerBitWidth() <= 32;
+}
+
 SCCP_Pass::SCCP_Pass() : FunctionPass(ID) {}
 
 bool SCCP_Pass::runOnFunction(llvm::Function &F) {
@@ -109,7 +150,11 @@ bool SCCP_Pass::runOnFunction(llvm::Function &F) {
           curr->begin(),
           curr->end(),
           [&](llvm::BasicBlock::iterator basic_block_inst){
-          transMngr.visit(basic_block_inst);
+          if (tracksType(basic_block_inst->getType())) {
+            transMngr.visit(basic_block_inst);
+          } else {
+            transMngr.markOverdefined(*basic_block_inst);
+          }
           });
     }
 
@@ -129,8 +174,11 @@ static RegisterPass<SCCP_Pass> X("sccp", "SCCP Pass", false, false);
 
 bool SCCP_Pass::doInitialization(llvm::Module& M){
   for (auto it =  M.global_begin(); it !=  M.global_end(); ++it){
-    this->globals.push_back(it);
+    // loads of the others are folded, see visitLoadInst
+    if (!holdsInitializer(*it)) {
+      this->globals.push_back(it);
     }
+  }
   return false;
 }
 
@@ -389,7 +437,8 @@ TRANSITION(visitICmpInst, llvm::ICmpInst &cmp){
 
   //none is top or botttom --> compute the value
   newInfo.state = LatticeState::value;
-  switch(cmp.getSignedPredicate()){
+  // the values are signed, so unsigned comparisons are not evaluated
+  switch(cmp.getPredicate()){
   case llvm::CmpInst::Predicate::ICMP_EQ:
     newInfo.value = (lhsInfo.value == rhsInfo.value);
     constantTable.checkedInsert(VALPAIR(&cmp, newInfo));
@@ -402,7 +451,12 @@ TRANSITION(visitICmpInst, llvm::ICmpInst &cmp){
     newInfo.value = (lhsInfo.value < rhsInfo.value);
     constantTable.checkedInsert(VALPAIR(&cmp, newInfo));
     return;
-  default://FIXME: Maybe map unsupported ops to top
+  default:
+    if(oldInfo.state != LatticeState::top){
+      newInfo.state = LatticeState::top;
+      constantTable.checkedInsert(VALPAIR(&cmp, newInfo));
+      this->enqueueCFGSuccessors(cmp);
+    }
     return;
   }
 
@@ -454,7 +508,8 @@ TRANSITION(visitTruncInst, llvm::TruncInst & trunc){
 }
 
 /*
- * Same as visitGetElementPtrInst
+ * Same as visitGetElementPtrInst, except for loads of globals which always
+ * hold their initializer
  */
 TRANSITION(visitLoadInst, llvm::LoadInst& load){
   auto info = this->getConstantLatticeElem(&load);
@@ -462,6 +517,17 @@ TRANSITION(visitLoadInst, llvm::LoadInst& load){
   //does not change
   if (info.state == LatticeState::top)
           return;
+  // the uses are checked again, as earlier passes may have changed them
+  auto global = dyn_cast<llvm::GlobalVariable>(load.getPointerOperand());
+  if (global && holdsInitializer(*global)) {
+    if (info.state == LatticeState::value)
+      return;
+    info.state = LatticeState::value;
+    info.value = cast<ConstantInt>(global->getInitializer())->getSExtValue();
+    constantTable.checkedInsert(std::make_pair(&load, info));
+    this->enqueueCFGSuccessors(load);
+    return;
+  }
   info.state = LatticeState::top;
   constantTable.checkedInsert(std::make_pair(&load, info));
   this->enqueueCFGSuccessors(load);
@@ -659,6 +725,15 @@ TRANSITION(visitIntToPtrInst, llvm::IntToPtrInst& intPtr){
 
 }
 
+void Transition::markOverdefined(llvm::Instruction &inst){
+  auto info = this->getConstantLatticeElem(&inst);
+  if (info.state == LatticeState::top)
+          return;
+  info.state = LatticeState::top;
+  constantTable.checkedInsert(VALPAIR(&inst, info));
+  this->enqueueCFGSuccessors(inst);
+}
+
 /*
  * Enqueues all CFG successors of a given instruction by taking its 
  * use chain and adding the uses parents
@@ -684,7 +759,7 @@ void Transition::enqueueCFGSuccessors(llvm::Instruction &inst){
 
 ConstantLattice Transition::getConstantLatticeElem(llvm::Value* val){
   //first check if we are dealing with a constant
-  if(llvm::isa<llvm::ConstantInt>(val)){
+  if(llvm::isa<llvm::ConstantInt>(val) && tracksType(val->getType())){
     auto asConst = llvm::cast<llvm::ConstantInt>(val);
     int value = asConst->getLimitedValue();
     ConstantLattice info;
@@ -775,7 +850,7 @@ void Transition::tearDownInsts(){
           asInst->eraseFromParent();
         }else{
         //we need to know if we have to handle a branch or a return inst
-        auto type = llvm::Type::getInt32Ty(llvm::getGlobalContext());
+        auto type = asInst->getType();
         auto constVal = llvm::ConstantInt::get(type, info.value, true);
         llvm::BasicBlock::iterator ii (asInst);
         ReplaceInstWithValue(asInst->getParent()->getInstList(),ii,constVal);
@@ -5,6 +5,7 @@
 #include "llvm/Pass.h"
 #include "llvm/PassAnalysisSupport.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/InstVisitor.h"
 
@@ -41,8 +42,12 @@ class BlockTable : public std::map<llvm::BasicBlock*, Reachability>
     void checkedInsert(std::pair<llvm::BasicBlock*, Reachability> pair);
 };
 
+// whether the loads of global can be folded to its initializer, see sccp_pass.cc
+bool holdsInitializer(llvm::GlobalVariable& global);
+
 struct SCCP_Pass : public llvm::FunctionPass {
   static char ID;
+  // the globals whose contents we know nothing about
   std::vector<llvm::Value*>globals;
 
   SCCP_Pass();
@@ -80,6 +85,8 @@ struct Transition: public llvm::InstVisitor<Transition, void> {
   void visitPtrToIntInst(llvm::PtrToIntInst& ptrInt);
   void visitIntToPtrInst(llvm::IntToPtrInst& intPtr);
 
+  // for values the lattice cannot hold, see tracksType
+  void markOverdefined(llvm::Instruction& inst);
   void enqueueCFGSuccessors(llvm::Instruction& inst);
   
   void deleteDeadBlocks();
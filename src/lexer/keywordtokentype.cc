@@ -42,10 +42,14 @@ std::string KeywordType2String(const KeywordType kt) {
     {KeywordType::GOTO,"goto"},
     {KeywordType::IF,"if"},
     {KeywordType::INT, "int"},
+    {KeywordType::LONG, "long"},
+    {KeywordType::RESTRICT, "restrict"},
     {KeywordType::RETURN, "return"},
     {KeywordType::SIZEOF, "sizeof"},
+    {KeywordType::STATIC, "static"},
     {KeywordType::STRUCT, "struct"},
     {KeywordType::SWITCH, "switch"},
+    {KeywordType::UNSIGNED, "unsigned"},
     {KeywordType::VOID, "void"},
     {KeywordType::WHILE, "while"},
   };
@@ -25,10 +25,14 @@ enum class KeywordType {
   GOTO,
   IF,
   INT,
+  LONG,
+  RESTRICT,
   RETURN,
   SIZEOF,
+  STATIC,
   STRUCT,
   SWITCH,
+  UNSIGNED,
   VOID,
   WHILE,
   WHO_CARES
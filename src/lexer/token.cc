@@ -82,10 +82,14 @@ const KeywordType & KeywordToken::string2keyword(std::string value) {
     {"goto", KeywordType::GOTO},
     {"if", KeywordType::IF},
     {"int", KeywordType::INT},
+    {"long", KeywordType::LONG},
+    {"restrict", KeywordType::RESTRICT},
     {"return", KeywordType::RETURN},
     {"sizeof", KeywordType::SIZEOF},
+    {"static", KeywordType::STATIC},
     {"struct", KeywordType::STRUCT},
     {"switch", KeywordType::SWITCH},
+    {"unsigned", KeywordType::UNSIGNED},
     {"void", KeywordType::VOID},
     {"while", KeywordType::WHILE},
   };
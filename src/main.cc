@@ -8,6 +8,10 @@
 #include <fstream>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cctype>
+#include <thread>
 #include "parser/pprinter.h"
 #include "codegen/cogen.h"
 #include "utils/debug.h"
@@ -22,8 +26,21 @@ enum class Mode {
   PRINT_AST,
   COMPILE,
   OPTIMIZE,
+  RUN,
 };
 
+// the number after the = of arg, which must consist of digits only
+static unsigned parseCount(char const* const arg, char const* const number)
+{
+  char* end;
+  auto count = std::strtoul(number, &end, 10);
+  if (!std::isdigit(static_cast<unsigned char>(*number)) || *end != '\0') {
+    errorf("expected a number in '%s'", arg);
+    return 0;
+  }
+  return count;
+}
+
 int main(int argc, char** const argv)
 {
   // speed up I/O
@@ -34,10 +51,15 @@ int main(int argc, char** const argv)
   llvm::sys::PrintStackTraceOnErrorSignal();
   llvm::PrettyStackTraceProgram X(argc, argv);
 
+  // set by --run to the exit code of the program
+  int exitCode = 0;
   try {
     char** i = argv + 1;
 
     Mode mode = Mode::COMPILE;
+    Codegeneration::Options codegenOptions;
+    char const *output = nullptr;
+    unsigned semanticWorkers = 0;
     for (; auto const arg = *i; ++i) {
       if (arg[0] != '-') {
         break;
@@ -49,20 +71,83 @@ int main(int argc, char** const argv)
         mode = Mode::PRINT_AST;
       } else if (strEq(arg, "--compile")) {
         mode = Mode::COMPILE;
-      } else if (strEq(arg, "--optimize")) {
-        mode = Mode::OPTIMIZE;
+        // undoes an earlier --optimize; -On after --compile still applies
+        codegenOptions.optLevel = Codegeneration::OptLevel::O0;
+      } else if (strEq(arg, "--optimize") || strEq(arg, "-Osccp")) {
+        // together with --run, the program is optimized before it is run
+        if (mode != Mode::RUN) {
+          mode = Mode::OPTIMIZE;
+        }
+        codegenOptions.optLevel = Codegeneration::OptLevel::SCCP;
+      } else if (strEq(arg, "-O0")) {
+        codegenOptions.optLevel = Codegeneration::OptLevel::O0;
+      } else if (strEq(arg, "-O1")) {
+        codegenOptions.optLevel = Codegeneration::OptLevel::O1;
+      } else if (strEq(arg, "-O2")) {
+        codegenOptions.optLevel = Codegeneration::OptLevel::O2;
+      } else if (strEq(arg, "-O3")) {
+        codegenOptions.optLevel = Codegeneration::OptLevel::O3;
+      } else if (strEq(arg, "--run")) {
+        mode = Mode::RUN;
+      } else if (strEq(arg, "-g")) {
+        codegenOptions.debugInfo = true;
+      } else if (strEq(arg, "--no-tbaa")) {
+        codegenOptions.typeBasedAliasAnalysis = false;
+      } else if (strEq(arg, "--instrument")) {
+        codegenOptions.instrument = true;
+      } else if (std::strncmp(arg, "--instrument=", 13) == 0) {
+        codegenOptions.instrument = true;
+        codegenOptions.profileOutput = arg + 13;
+      } else if (std::strncmp(arg, "--profile-use=", 14) == 0) {
+        codegenOptions.profileInput = arg + 14;
+      } else if (std::strncmp(arg, "--unroll=", 9) == 0) {
+        codegenOptions.unrollCount = parseCount(arg, arg + 9);
+      } else if (strEq(arg, "--vectorize")) {
+        codegenOptions.vectorize = true;
+      } else if (strEq(arg, "--stats")) {
+        codegenOptions.printStatistics = true;
+      } else if (strEq(arg, "--emit=ll")) {
+        codegenOptions.emit = Codegeneration::Emit::LLVM;
+      } else if (strEq(arg, "--emit=bc")) {
+        codegenOptions.emit = Codegeneration::Emit::BITCODE;
+      } else if (strEq(arg, "--emit=asm")) {
+        codegenOptions.emit = Codegeneration::Emit::ASSEMBLY;
+      } else if (strEq(arg, "--emit=obj")) {
+        codegenOptions.emit = Codegeneration::Emit::OBJECT;
+      } else if (strEq(arg, "-o")) {
+        if (!*++i) {
+          errorf("missing file name after '-o'");
+          break;
+        }
+        output = *i;
+      } else if (strEq(arg, "--parallel-sema")) {
+        semanticWorkers = std::max(1u, std::thread::hardware_concurrency());
+      } else if (std::strncmp(arg, "--parallel-sema=", 16) == 0) {
+        semanticWorkers = parseCount(arg, arg + 16);
+      } else if (strEq(arg, "--parallel-opt")) {
+        codegenOptions.optimizationWorkers =
+          std::max(1u, std::thread::hardware_concurrency());
+      } else if (std::strncmp(arg, "--parallel-opt=", 15) == 0) {
+        codegenOptions.optimizationWorkers = parseCount(arg, arg + 15);
       } else if (strEq(arg, "-")) {
         break;
       } else if (strEq(arg, "--")) {
         ++i;
         break;
       } else {
-        errorf("unknown arguments '%s', use --tokenize|parse|print-ast|compile|optimize", arg);
+        errorf("unknown arguments '%s', use --tokenize|parse|print-ast|compile|optimize|run [-O0|1|2|3|sccp] [-g] [--no-tbaa] [--instrument[=FILE]] [--profile-use=FILE] [--unroll=N] [--vectorize] [--stats] [--parallel-sema[=N]] [--parallel-opt[=N]] [--emit=ll|bc|asm|obj] [-o FILE]", arg);
       }
     }
 
+    // --optimize only runs mem2reg and SCCP, which ignore the loop hints
+    if (codegenOptions.optLevel == Codegeneration::OptLevel::SCCP
+        && (codegenOptions.unrollCount || codegenOptions.vectorize))
+      errorf("--unroll and --vectorize need -O1, -O2 or -O3, not --optimize");
+
     if (!*i)
       errorf("no input files specified");
+    else if (output && i[1] && mode != Mode::RUN)
+      errorf("-o cannot be used with more than one input file");
 
     if (!hasNewErrors()) {
       for (; char const *name = *i; ++i) {
@@ -90,7 +175,7 @@ int main(int argc, char** const argv)
             break;
           case Mode::PARSE:
           {
-            auto parser = Parsing::Parser{f, name};
+            auto parser = Parsing::Parser{f, name, semanticWorkers};
             if (parser.parse()) {
               debug(GENERAL) << "PARSING SUCCESSFUL\n";
             } else {
@@ -100,23 +185,55 @@ int main(int argc, char** const argv)
           }
           case Mode::PRINT_AST:
           {
-            auto parser = Parsing::Parser{f, name};
+            auto parser = Parsing::Parser{f, name, semanticWorkers};
             auto ast = parser.parse();
             pprint(ast, 0);
             break;
           }
           case Mode::OPTIMIZE:
           case Mode::COMPILE:
-            std::string namecpy(name);
-            auto last_slash = namecpy.rfind('/');
-            auto basename = namecpy.substr(last_slash + 1);
-            //                             exclude slash from string
-            basename.pop_back(); // remove the c ending
-            basename += "ll"; // append ll instead
-            auto parser = Parsing::Parser{f, name};
+          {
+            std::string basename;
+            if (output) {
+              basename = output;
+            } else {
+              std::string namecpy(name);
+              auto last_slash = namecpy.rfind('/');
+              basename = namecpy.substr(last_slash + 1);
+              //                             exclude slash from string
+              basename.pop_back(); // remove the c ending
+              switch (codegenOptions.emit) { // append the new one instead
+                case Codegeneration::Emit::LLVM:     basename += "ll"; break;
+                case Codegeneration::Emit::BITCODE:  basename += "bc"; break;
+                case Codegeneration::Emit::ASSEMBLY: basename += "s";  break;
+                case Codegeneration::Emit::OBJECT:   basename += "o";  break;
+              }
+            }
+            auto parser = Parsing::Parser{f, name, semanticWorkers};
+            auto ast = parser.parse();
+            Parsing::CompilationContext::Activation activation(
+                *parser.compilationContext());
+            Codegeneration::genLLVMIR(basename.c_str(), ast, codegenOptions);
+            break;
+          }
+          case Mode::RUN:
+          {
+            auto parser = Parsing::Parser{f, name, semanticWorkers};
             auto ast = parser.parse();
-            Codegeneration::genLLVMIR(basename.c_str(), ast, (mode == Mode::OPTIMIZE));
+            Parsing::CompilationContext::Activation activation(
+                *parser.compilationContext());
+            // the file is the program's argv[0], the remaining arguments
+            // are passed to it as well
+            auto last = i;
+            while (last[1]) {
+              ++last;
+            }
+            std::vector<std::string> arguments(i, last + 1);
+            exitCode = Codegeneration::runLLVMIR(name, ast, codegenOptions,
+                                                 arguments);
+            i = last;
             break;
+          }
         }
 
         if (f != stdin)
@@ -153,5 +270,6 @@ int main(int argc, char** const argv)
     errorf("caught unknown exception");
   }
 
-  return printDiagnosticSummary();
+  auto status = printDiagnosticSummary();
+  return status ? status : exitCode;
 }
@@ -1,5 +1,7 @@
 #include <sstream>
 #include <memory>
+#include <cstdint>
+#include <stdexcept>
 #include "ast.h"
 #include "pprinter.h"
 #include "parser.h"
@@ -13,6 +15,92 @@ using namespace Semantic;
 
 namespace {
 
+/*
+ * The classes of operand types the operator rules below are written in;
+ * every type belongs to exactly one of them
+ */
+enum OperandClass : unsigned {
+  NONE       = 0,
+  ARITHMETIC = 1 << 0,
+  POINTER    = 1 << 1,
+  FUNCTION   = 1 << 2,
+  STRUCT     = 1 << 3,
+  VOID       = 1 << 4,
+  SCALAR     = ARITHMETIC | POINTER | FUNCTION,
+  OBJECT     = ARITHMETIC | POINTER | STRUCT | VOID,
+};
+
+unsigned operandClass(const SemanticDeclarationNode & s) {
+  if (!s) {
+    return NONE;
+  }
+  switch (s->type()) {
+    case Semantic::Type::INT:
+    case Semantic::Type::CHAR:
+    case Semantic::Type::LONG:
+    case Semantic::Type::UNSIGNED:
+    case Semantic::Type::UNSIGNED_LONG:
+      return ARITHMETIC;
+    case Semantic::Type::POINTER:
+    case Semantic::Type::ARRAY:
+      return POINTER;
+    case Semantic::Type::FUNCTION:
+      return FUNCTION;
+    case Semantic::Type::STRUCT:
+      return STRUCT;
+    case Semantic::Type::VOID:
+      return VOID;
+    default:
+      return NONE;
+  }
+}
+
+// returns s as a pointer declaration if it is one (arrays included)
+PointerDeclaration* asPointer(const SemanticDeclarationNode & s) {
+  return operandClass(s) == POINTER ? static_cast<PointerDeclaration*>(s.get())
+                                    : nullptr;
+}
+
+/*
+ * Integer arithmetic of the folded constants; it wraps around like the
+ * 32 bit operations the code generator would emit
+ */
+int wrap(int64_t value) {
+  return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+/*
+ * Whether the arithmetic on values of the type is the one of the folded
+ * constants; arithmetic on long and unsigned operands is left to the code
+ * generator
+ */
+bool foldsLikeInt(const SemanticDeclarationNode & s) {
+  return s->type() == Semantic::Type::INT || s->type() == Semantic::Type::CHAR;
+}
+
+// size of the type if it does not depend on the target, otherwise -1
+long constantSize(const SemanticDeclarationNode & s) {
+  switch (operandClass(s)) {
+    case ARITHMETIC:
+      switch (s->type()) {
+        case Semantic::Type::CHAR:
+          return 1;
+        case Semantic::Type::LONG:
+        case Semantic::Type::UNSIGNED_LONG:
+          return 8;
+        default:
+          return 4;
+      }
+    case POINTER:
+      if (auto as_array = std::dynamic_pointer_cast<ArrayDeclaration>(s)) {
+        return as_array->size;
+      }
+      return -1;
+    default:
+      return -1;
+  }
+}
+
 bool validAssignment(SemanticDeclarationNode lhs,SubExpression rhs) {
   auto valid = false;
   if (compareTypes(lhs, rhs->getType())) {
@@ -27,7 +115,7 @@ bool validAssignment(SemanticDeclarationNode lhs,SubExpression rhs) {
     if (isNullPtrConstant(rhs)) {
       rhs->setType(lhs);
       return true;
-    } else if (auto rhs_as_ptr = std::dynamic_pointer_cast<PointerDeclaration>(rhs->getType())) {
+    } else if (auto rhs_as_ptr = asPointer(rhs->getType())) {
       if (rhs_as_ptr->pointee()->type() == Semantic::Type::VOID) {
         return true;
       }
@@ -41,6 +129,9 @@ bool validAssignment(SemanticDeclarationNode lhs,SubExpression rhs) {
     switch (lhs->type()) {
       case Semantic::Type::INT:
       case Semantic::Type::CHAR:
+      case Semantic::Type::LONG:
+      case Semantic::Type::UNSIGNED:
+      case Semantic::Type::UNSIGNED_LONG:
         rhs->setType(promoteType(lhs));
         return true;
         break;
@@ -48,7 +139,7 @@ bool validAssignment(SemanticDeclarationNode lhs,SubExpression rhs) {
         break;
     }
   }
-  if (auto lhs_as_ptr = std::dynamic_pointer_cast<PointerDeclaration>(lhs)) {
+  if (auto lhs_as_ptr = asPointer(lhs)) {
     if (lhs_as_ptr->pointee()->type() == Semantic::Type::VOID) {
       if (rhs->getType()->type() == Semantic::Type::POINTER) {
         return true;
@@ -58,6 +149,348 @@ bool validAssignment(SemanticDeclarationNode lhs,SubExpression rhs) {
   return valid;
 }
 
+enum class ResultRule {
+  INT,        // the result is an int
+  SIZE,       // the result is a size_t, i.e. an unsigned long
+  PROMOTED,   // the result is the promoted type of the (first) operand
+  CONVERTED,  // the result is the type of the usual arithmetic conversions
+  POINTER,    // the result has the type of the pointer operand
+  POINTEE,    // the result is the object the pointer operand points to
+  DIFFERENCE, // the result is a ptrdiff_t, i.e. a long
+  ASSIGNED,   // the result has the type of the left operand
+  MEMBER,     // the result is the struct member named by the right operand
+};
+
+enum class LvalueRule {
+  NEVER,
+  ALWAYS,
+  LEFT,       // the result is an lvalue if the left operand is one
+};
+
+/*
+ * Constraints of an operator form that the operand classes cannot express,
+ * mostly about the pointees of pointer operands. A check returns false if
+ * the form does not apply to the operands, and throws if the form applies,
+ * but the operands violate its constraints.
+ */
+typedef bool (*FormCheck)(const SubExpression & lhs, const SubExpression & rhs,
+                          const Pos & operatorPosition);
+
+// 6.5.6 $3: the pointer must point to a complete object type
+bool completePointee(const SubExpression & lhs, const SubExpression &,
+                     const Pos &) {
+  if (!isCompleteObjectType(asPointer(lhs->getType())->pointee())) {
+    throw ParsingException(
+        std::string("- requires pointer to point to complete object type"),
+        lhs->pos());
+  }
+  return true;
+}
+
+// 6.5.6 $3: pointers to compatible complete object types
+bool subtractablePointers(const SubExpression & lhs, const SubExpression & rhs,
+                          const Pos & operatorPosition) {
+  completePointee(lhs, rhs, operatorPosition);
+  if (!compareTypes(asPointer(lhs->getType())->pointee(),
+                    asPointer(rhs->getType())->pointee())) {
+    throw ParsingException(lhs->getType()->toString()
+        + " and " + rhs->getType()->toString()
+        + " are not pointers to compatible types", operatorPosition);
+  }
+  return true;
+}
+
+// 6.5.8 $2: pointers to compatible object types
+bool comparablePointers(const SubExpression & lhs, const SubExpression & rhs,
+                        const Pos & operatorPosition) {
+  auto lhs_as_ptr = asPointer(lhs->getType());
+  auto rhs_as_ptr = asPointer(rhs->getType());
+  // TODO: function pointer conversion must fail
+  if (!(isObjectType(lhs_as_ptr->pointee()) && isObjectType(rhs_as_ptr->pointee()))) {
+    throw ParsingException(std::string(
+          "Pointers must both point to object types, but lhs was "
+          + lhs_as_ptr->toString() + " and rhs was "
+          + rhs_as_ptr->toString()
+           ), operatorPosition);
+  }
+  if (!compareTypes(lhs_as_ptr->pointee(), rhs_as_ptr->pointee())) {
+    throw ParsingException(
+        std::string("Pointer point to different types: ")
+        + lhs_as_ptr->pointee()->toString() + " and "
+        + rhs_as_ptr->pointee()->toString(),
+        operatorPosition);
+  }
+  return true;
+}
+
+/*
+ * 6.5.9 $2: pointers to compatible types, or a pointer to an object type and
+ * a pointer to void
+ */
+bool equatablePointers(const SubExpression & lhs, const SubExpression & rhs,
+                       const Pos & operatorPosition) {
+  auto lpointee = asPointer(lhs->getType())->pointee();
+  auto rpointee = asPointer(rhs->getType())->pointee();
+  if (   (isObjectType(lpointee) && rpointee->type() == Semantic::Type::VOID)
+      || (isObjectType(rpointee) && lpointee->type() == Semantic::Type::VOID)
+      || compareTypes(lpointee, rpointee)) {
+    return true;
+  }
+  ostringstream errmsg;
+  errmsg << "Operands of equality operator are not compatible! Types were: "
+    << lhs->getType()->toString() << " and "
+    << rhs->getType()->toString();
+  throw ParsingException(errmsg.str(), operatorPosition);
+}
+
+// 6.5.9 $2: a pointer and a null pointer constant, which becomes a pointer
+bool nullPointerRight(const SubExpression & lhs, const SubExpression & rhs,
+                      const Pos &) {
+  if (!isNullPtrConstant(rhs)) {
+    return false;
+  }
+  rhs->setType(lhs->getType());
+  return true;
+}
+
+bool nullPointerLeft(const SubExpression & lhs, const SubExpression & rhs,
+                     const Pos & operatorPosition) {
+  return nullPointerRight(rhs, lhs, operatorPosition);
+}
+
+// 6.5.16.1
+bool assignable(const SubExpression & lhs, const SubExpression & rhs,
+                const Pos & operatorPosition) {
+  /* 6.5.16 $2:
+   * An assignment operator shall have a modifiable lvalue as its left operand.
+   * WARNING: We currently don't have non-modifiable lvalues, because string
+   * literals are not lvalues in our implementation and const does not exist;
+   * as soon as this changes, the check below is not sufficiant enough
+   */
+  if (!lhs->can_be_lvalue()) {
+    throw ParsingException("The left operand of an assignment must be a lvalue",
+         operatorPosition);
+  }
+  if (!validAssignment(lhs->getType(), rhs)) {
+    std::stringstream errmsg;
+    errmsg << "Assignment invalid, <descriptive error messages here>!\n"
+           << "lhs has type " << lhs->getType()->toString() << '\n'
+           << "rhs has type " << rhs->getType()->toString() << '\n';
+    throw ParsingException(errmsg.str(), operatorPosition);
+  }
+  return true;
+}
+
+// 6.5.2.3 $2: -> requires a pointer to a struct
+bool pointsToStruct(const SubExpression & lhs, const SubExpression &,
+                    const Pos &) {
+  auto pointee = asPointer(lhs->getType())->pointee();
+  if (operandClass(pointee) != STRUCT) {
+    throw ParsingException(std::string(
+        "Trying to access struct member, but left operand is not a struct, but a "
+        + pointee->toString()), lhs->pos());
+  }
+  return true;
+}
+
+/*
+ * One combination of operand classes an operator accepts, with the type of
+ * its result. An rhs of NONE is not checked; unary operators have no right
+ * operand, and the right operand of . and -> is a member name.
+ */
+struct OperatorForm {
+  unsigned lhs;
+  unsigned rhs;
+  ResultRule result;
+  FormCheck check;
+  LvalueRule lvalue;
+};
+
+/*
+ * An operator rule lists the forms of an operator, which are tried in order.
+ * If none applies, the left operand is reported if no form accepts its class,
+ * the right operand otherwise. Operators without forms are checked by hand.
+ */
+struct OperatorRule {
+  static constexpr size_t maxForms = 4;
+  OperatorForm forms[maxForms];
+  const char* lhsError;
+  const char* rhsError;
+
+  bool hasForms() const {
+    return forms[0].lhs != NONE;
+  }
+};
+
+struct OperatorRules {
+  static constexpr size_t size = static_cast<size_t>(PunctuatorType::ILLEGAL) + 1;
+  OperatorRule binary[size];
+  OperatorRule unary[size];
+
+  OperatorRules() {
+    for (size_t i = 0; i < size; ++i) {
+      binary[i] = unary[i] = OperatorRule();
+    }
+    // 6.5.2.1
+    binary[index(PunctuatorType::ARRAY_ACCESS)] = {{
+      {POINTER, ARITHMETIC, ResultRule::POINTEE, nullptr, LvalueRule::ALWAYS},
+      {ARITHMETIC, POINTER, ResultRule::POINTEE, nullptr, LvalueRule::ALWAYS}},
+      "Array subscript requires a pointer and an integer, but the left operand is ",
+      "Array subscript requires a pointer and an integer, but the right operand is "};
+    // 6.5.2.3
+    binary[index(PunctuatorType::MEMBER_ACCESS)] = {{
+      {STRUCT, NONE, ResultRule::MEMBER, nullptr, LvalueRule::LEFT}},
+      "Trying to access struct member, but left operand is not a struct, but a ",
+      nullptr};
+    binary[index(PunctuatorType::ARROW)] = {{
+      {POINTER, NONE, ResultRule::MEMBER, pointsToStruct, LvalueRule::ALWAYS}},
+      "Operator -> requires a pointer to a struct, but got ",
+      nullptr};
+    // 6.5.5
+    binary[index(PunctuatorType::STAR)] = {{
+      {ARITHMETIC, ARITHMETIC, ResultRule::CONVERTED, nullptr, LvalueRule::NEVER}},
+      "Multiplication requires that the left operand has arithmetic type, but it is ",
+      "Multiplication requires that the right operand has arithmetic type, but it is "};
+    // 6.5.6
+    binary[index(PunctuatorType::PLUS)] = {{
+      {ARITHMETIC, ARITHMETIC, ResultRule::CONVERTED, nullptr, LvalueRule::NEVER},
+      {ARITHMETIC, POINTER, ResultRule::POINTER, nullptr, LvalueRule::NEVER},
+      {POINTER, ARITHMETIC, ResultRule::POINTER, nullptr, LvalueRule::NEVER}},
+      "Incompatible types for +, the left operand is ",
+      "Incompatible types for +, the right operand is "};
+    binary[index(PunctuatorType::MINUS)] = {{
+      {ARITHMETIC, ARITHMETIC, ResultRule::CONVERTED, nullptr, LvalueRule::NEVER},
+      {POINTER, ARITHMETIC, ResultRule::POINTER, completePointee, LvalueRule::NEVER},
+      {POINTER, POINTER, ResultRule::DIFFERENCE, subtractablePointers, LvalueRule::NEVER}},
+      "Incompatible types for -, the left operand is ",
+      "Incompatible types for -, the right operand is "};
+    // 6.5.8
+    binary[index(PunctuatorType::LESS)] = {{
+      {ARITHMETIC, ARITHMETIC, ResultRule::INT, nullptr, LvalueRule::NEVER},
+      {POINTER, POINTER, ResultRule::INT, comparablePointers, LvalueRule::NEVER}},
+      "Comparision requires both operands to be either pointer to object or to be of real type, but the left operand is ",
+      "Comparision requires both operands to be either pointer to object or to be of real type, but the right operand is "};
+    // 6.5.9
+    binary[index(PunctuatorType::EQUAL)] = binary[index(PunctuatorType::NEQUAL)] = {{
+      {ARITHMETIC, ARITHMETIC, ResultRule::INT, nullptr, LvalueRule::NEVER},
+      {POINTER, POINTER, ResultRule::INT, equatablePointers, LvalueRule::NEVER},
+      {POINTER, ARITHMETIC, ResultRule::INT, nullPointerRight, LvalueRule::NEVER},
+      {ARITHMETIC, POINTER, ResultRule::INT, nullPointerLeft, LvalueRule::NEVER}},
+      "Comparision requires both operands to be either pointer to object or to be of arithmetic type, but the left operand is ",
+      "Comparision requires both operands to be either pointer to object or to be of arithmetic type, but the right operand is "};
+    // 6.5.13, 6.5.14
+    binary[index(PunctuatorType::LAND)] = binary[index(PunctuatorType::LOR)] = {{
+      {SCALAR, SCALAR, ResultRule::INT, nullptr, LvalueRule::NEVER}},
+      "Logical operator requires operands with scalar type, but left operand is ",
+      "Logical operator requires operands with scalar type, but right operand is "};
+    // 6.5.16
+    binary[index(PunctuatorType::ASSIGN)] = {{
+      {SCALAR | OBJECT, SCALAR | OBJECT, ResultRule::ASSIGNED, assignable, LvalueRule::NEVER}},
+      "Invalid left operand of assignment of type ",
+      "Invalid right operand of assignment of type "};
+    // 6.5.3.3
+    unary[index(PunctuatorType::MINUS)] = {{
+      {ARITHMETIC, NONE, ResultRule::PROMOTED, nullptr, LvalueRule::NEVER}},
+      "Operator - requires an arithmetic type, but got ", nullptr};
+    unary[index(PunctuatorType::NOT)] = {{
+      {SCALAR, NONE, ResultRule::INT, nullptr, LvalueRule::NEVER}},
+      "Operator '!' requires an operand of scalar type, but got ", nullptr};
+    // 6.5.3.4
+    unary[index(PunctuatorType::SIZEOF)] = {{
+      {OBJECT, NONE, ResultRule::SIZE, nullptr, LvalueRule::NEVER}},
+      "Illegal application of 'sizeof' to ", nullptr};
+  }
+
+  static size_t index(PunctuatorType op) {
+    return static_cast<size_t>(op);
+  }
+};
+
+const OperatorRules & operatorRules() {
+  static const OperatorRules rules;
+  return rules;
+}
+
+/*
+ * The first form of rule which applies to the operands; rhs is null for
+ * unary operators
+ */
+const OperatorForm & matchForm(const OperatorRule & rule,
+                               const SubExpression & lhs,
+                               const SubExpression & rhs,
+                               const Pos & operatorPosition) {
+  auto lhsClass = operandClass(lhs->getType());
+  auto rhsClass = rhs ? operandClass(rhs->getType()) : NONE;
+  auto lhsAccepted = false;
+  for (auto & form : rule.forms) {
+    if (form.lhs == NONE) {
+      break;
+    }
+    if (!(form.lhs & lhsClass)) {
+      continue;
+    }
+    lhsAccepted = true;
+    if (form.rhs != NONE && !(form.rhs & rhsClass)) {
+      continue;
+    }
+    if (!form.check || form.check(lhs, rhs, operatorPosition)) {
+      return form;
+    }
+  }
+  auto & operand = lhsAccepted ? rhs : lhs;
+  auto type = operand->getType();
+  throw ParsingException(std::string(lhsAccepted ? rule.rhsError : rule.lhsError)
+                         + (type ? type->toString() : "INITIALIZE ME!"),
+                         operand->pos());
+}
+
+// other is the right operand of binary operators
+SemanticDeclarationNode resultType(ResultRule rule, const SubExpression & operand,
+                                   const SubExpression & other = SubExpression{}) {
+  switch (rule) {
+    case ResultRule::PROMOTED:
+      return promoteType(operand->getType());
+    case ResultRule::CONVERTED:
+      return applyUsualConversions(operand->getType(), other->getType()).first;
+    case ResultRule::SIZE:
+      return types().unsignedLongType();
+    case ResultRule::POINTER:
+      return asPointer(operand->getType()) ? operand->getType() : other->getType();
+    case ResultRule::POINTEE:
+      if (auto pointer = asPointer(operand->getType())) {
+        return pointer->pointee();
+      }
+      return asPointer(other->getType())->pointee();
+    case ResultRule::DIFFERENCE:
+      return types().longType();
+    case ResultRule::ASSIGNED:
+      return operand->getType();
+    default:
+      return types().intType();
+  }
+}
+
+/*
+ * The type of the member named by member in the struct operand is or points
+ * to; its position in the struct is stored in index
+ */
+SemanticDeclarationNode memberType(const SubExpression & operand,
+                                   const SubExpression & member,
+                                   unsigned & index) {
+  auto structType = operand->getType();
+  if (auto pointer = asPointer(structType)) {
+    structType = pointer->pointee();
+  }
+  auto identifier = std::dynamic_pointer_cast<VariableUsage>(member);
+  if (!identifier) {
+    throw ParsingException(
+        "Trying to access struct member, but right operand is not an identifier",
+        operand->pos());
+  }
+  return identifier->getType(
+      static_cast<StructDeclaration*>(structType.get())->node(), index);
+}
+
 }
 
 BinaryExpression::BinaryExpression(SubExpression lhs,
@@ -67,279 +500,93 @@ BinaryExpression::BinaryExpression(SubExpression lhs,
   Expression(pos),
   lhs(lhs),
   rhs(rhs),
-  op(op)
+  op(op),
+  operatorPosition(operator_position ? *operator_position : pos),
+  memberIndex(0)
+{
+}
+
+void BinaryExpression::analyze(SemanticTree & semanticTree)
+{
+  lhs->analyze(semanticTree);
+  // the right operand of . and -> is looked up in the struct instead
+  if (op != PunctuatorType::ARROW && op != PunctuatorType::MEMBER_ACCESS) {
+    rhs->analyze(semanticTree);
+  }
+  auto & rule = operatorRules().binary[OperatorRules::index(op)];
+  if (!rule.hasForms()) {
+    throw ParsingException(std::string() + "Implement this! " + Lexing::PunctuatorType2String(op), pos());
+  }
+  auto & form = matchForm(rule, lhs, rhs, operatorPosition);
+  if (form.result == ResultRule::MEMBER) {
+    this->type = memberType(lhs, rhs, this->memberIndex);
+  } else {
+    this->type = resultType(form.result, lhs, rhs);
+  }
+  this->m_can_be_lvalue = form.lvalue == LvalueRule::ALWAYS
+    || (form.lvalue == LvalueRule::LEFT && lhs->can_be_lvalue());
+  foldConstant();
+}
+
+void BinaryExpression::markAddressTaken()
 {
-  SemanticDeclarationNode pointedToType;
+  // the address of a member lies inside the struct variable; -> leads
+  // through a pointer, which itself stays a value
+  if (op == PunctuatorType::MEMBER_ACCESS) {
+    lhs->markAddressTaken();
+  }
+}
+
+/*
+ * Folds integer constant expressions; && and || are also folded if their
+ * left operand alone decides the result, as the right one is never evaluated
+ */
+void BinaryExpression::foldConstant()
+{
+  if (operandClass(this->type) != ARITHMETIC || !lhs->hasConstantValue()) {
+    return;
+  }
+  int64_t l = lhs->constantValue();
+  if (op == PunctuatorType::LAND && !l) {
+    setConstantValue(0);
+    return;
+  }
+  if (op == PunctuatorType::LOR && l) {
+    setConstantValue(1);
+    return;
+  }
+  if (!rhs->hasConstantValue()) {
+    return;
+  }
+  if (   op != PunctuatorType::LAND && op != PunctuatorType::LOR
+      && !(foldsLikeInt(lhs->getType()) && foldsLikeInt(rhs->getType()))) {
+    return;
+  }
+  int64_t r = rhs->constantValue();
   switch (op) {
-    case PunctuatorType::ARRAY_ACCESS:
-      // 6.5.2.1
-      // left operand must have type pointer to object _type_
-      if (auto ltype = std::dynamic_pointer_cast<PointerDeclaration>(lhs->getType())) {
-        // right operand must have integer type
-        if (!hasIntegerType(rhs)) {
-        throw ParsingException(std::string(
-              "Right operand of array subscript must have integer type, but is a !"
-              + (rhs->getType() ?  rhs->getType()->toString() : "INITIALIZE ME!")), rhs->pos());
-        }
-        this->type = ltype->pointee();
-        this->m_can_be_lvalue = true;
-      } else if (auto rtype = std::dynamic_pointer_cast<PointerDeclaration>(rhs->getType())) {
-        if (!hasIntegerType(lhs)) {
-        throw ParsingException(std::string(
-              "Left operand of array subscript must have integer type, but is a !"
-              + (lhs->getType() ?  lhs->getType()->toString() : "INITIALIZE ME!")), lhs->pos());
-        }
-        this->type = rtype->pointee();
-        this->m_can_be_lvalue = true;
-      }  else {
-        throw ParsingException(std::string(
-              "Neither left nor right operand is a pointer! Left type is "
-              + (lhs->getType() ?  lhs->getType()->toString() : "INITIALIZE ME!")), pos);
-      }
+    case PunctuatorType::PLUS:
+      setConstantValue(wrap(l + r));
       break;
-    case PunctuatorType::ARROW: 
-      // mostly the same as MEMBER_ACCESS, therefore we just change one variable
-      // and (ab)use fall through
-      if (auto ltype = std::dynamic_pointer_cast<PointerDeclaration>(lhs->getType())) {
-        pointedToType = ltype->pointee();
-        // A postfix expression followed by the -> operator and an identifier designates a member
-        // of a structure or union object. The value is that of the named member of the object to
-        // which the first expression points, and is an lvalue.
-        this->m_can_be_lvalue = true;
-      } else {
-        throw ParsingException(std::string(  "Can't use operator -> on ")
-                                           + (lhs->getType()? lhs->getType()->toString() : "INITIALIZE ME!")
-                                           + ", pointer type required",
-                               lhs->pos());
-      }
-    case PunctuatorType::MEMBER_ACCESS:
-      // 6.5.2.3
-      // first operator shall have an atomic, qualified, or unqualified structure or union type
-      if (auto ltype = std::dynamic_pointer_cast<StructDeclaration>( (op == PunctuatorType::MEMBER_ACCESS) ?  lhs->getType() : pointedToType )) {
-        // identifier must follow
-        if (auto identifier = std::dynamic_pointer_cast<VariableUsage>(rhs)) {
-          this->type = identifier->getType(ltype->node());
-          if (!this->m_can_be_lvalue) {
-            // if we actually handle ARROW (instead of MEMBER_ACCESS) we must
-            // not change the value of m_can_be_lvalue; luckily the parent
-            // constructor always sets the value to false, and ARROW always sets
-            // it to true before we reach this point; so if it is false, we know
-            // that we are in the MEMBER_ACCESS case and have to react
-            // accordingly:
-            // 6.5.2.3 $3: and is an lvalue if the first expression is an lvalue
-            this->m_can_be_lvalue = lhs->can_be_lvalue();
-          }
-        } else {
-          throw ParsingException(std::string(
-              "Trying to access struct member, but right operand is not an identifier , but a "
-              + (rhs->getType() ?  rhs->getType()->toString() : "INITIALIZE ME!")), lhs->pos());
-        }
-      } else {
-        throw ParsingException(std::string(
-              "Trying to access struct member, but left operand is not a struct, but a "
-              + (lhs->getType() ?  lhs->getType()->toString() : "INITIALIZE ME!")), lhs->pos());
-      }
+    case PunctuatorType::MINUS:
+      setConstantValue(wrap(l - r));
       break;
     case PunctuatorType::STAR:
-      // 6.5.5
-      if (!hasArithmeticType(lhs)) { // TODO: should this be put into a function?
-        throw ParsingException(std::string(
-              "Multiplication requires that the left operand has arithmetic type"),
-            lhs->pos()
-            );
-      }
-      if (!hasArithmeticType(rhs)) {
-        throw ParsingException(std::string(
-              "Multiplication requires that the right operand has arithmetic type"),
-            rhs->pos()
-            );
-      }
-      this->type = make_shared<IntDeclaration>();
+      setConstantValue(wrap(l * r));
       break;
-    case PunctuatorType::PLUS: {
-      auto lhs_type = lhs->getType();
-      auto rhs_type = rhs->getType();
-      if (isArithmeticType(lhs_type) && isArithmeticType(rhs_type)) {
-        // TODO: apply usual conversions
-        this->type = make_shared<IntDeclaration>();
-        break;
-      }
-      shared_ptr<PointerDeclaration> t;
-      if (isIntegerType(lhs_type)) {
-        t = dynamic_pointer_cast<PointerDeclaration>(rhs_type);
-      } else if (isIntegerType(rhs_type)) {
-        t = dynamic_pointer_cast<PointerDeclaration>(lhs_type);
-      }
-      if (t) {
-        this->type = t;
-        break;
-      }
-      throw ParsingException(std::string("Incompatible types for +"), lhs->pos());
-    }
-    case PunctuatorType::MINUS: {
-      auto lhs_type = lhs->getType();
-      auto rhs_type = rhs->getType();
-      // For subtraction, one of the following shall hold:
-      if (isArithmeticType(lhs_type) && isArithmeticType(rhs_type)) {
-        // 1) both operands have arithmetic type
-        this->type = applyUsualConversions(lhs_type, rhs_type).first;
-        break;
-      }
-      auto lhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(lhs_type);
-      if (isIntegerType(rhs_type)) {
-        if (lhs_as_ptr) {
-          if (!isCompleteObjectType(lhs_as_ptr->pointee())) {
-            throw ParsingException(
-                std::string("- requires pointer to point to complete object type"),
-                lhs->pos()
-            );
-          }
-          // 2) the left operand is a pointer to a complete object type and the
-          // right operand has integer type.
-          this->type = lhs_as_ptr;
-          break;
-        }
-      }
-      auto rhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(rhs_type);
-      if (lhs_as_ptr && rhs_as_ptr) {
-        if (!isCompleteObjectType(lhs_as_ptr->pointee())) {
-          throw ParsingException(std::string("- requires pointer to point to complete object type"), lhs->pos());
-        }
-        // in real C this would be ptrdiff_t
-        if (compareTypes(lhs_as_ptr->pointee(), rhs_as_ptr->pointee())) {
-          // 3) both operands are pointers to qualified or unqualified versions
-          // of compatible complete object types
-          this->type = make_shared<IntDeclaration>();
-        } else {
-          throw ParsingException(lhs_type->toString()
-              + " and " + rhs_type->toString()
-              + " are not pointers to compatible types", pos);
-        }
-        break;
-      }
-      throw ParsingException(std::string("Incompatible types for -"), lhs->pos());
-    }
     case PunctuatorType::LESS:
-      if (hasRealType(lhs) && hasRealType(rhs)) {
-        // TODO: apply usual conversions
-        auto converted = applyUsualConversions(lhs->getType(),rhs->getType());
-        this->type = make_shared<IntDeclaration>();
-      } else {
-        auto lhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(lhs->getType());
-        auto rhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(rhs->getType());
-        // TODO: function pointer conversion must fail
-        if (lhs_as_ptr && rhs_as_ptr) {
-          if (!(isObjectType(lhs_as_ptr->pointee()) && isObjectType(rhs_as_ptr->pointee()))) {
-            throw ParsingException(std::string(
-                  "Pointers must both point to object types, but lhs was "
-                  + lhs_as_ptr->toString() + " and rhs was "
-                  + rhs_as_ptr->toString()
-                   ), this->pos());
-          }
-          if (compareTypes(lhs_as_ptr->pointee(), rhs_as_ptr->pointee())) {
-            this->type = make_shared<IntDeclaration>();
-          } else {
-            throw ParsingException(
-                std::string("Pointer point to different types: ")
-                + lhs_as_ptr->pointee()->toString() + " and "
-                + rhs_as_ptr->pointee()->toString(),
-                this->pos());
-          }
-        } else {
-          throw ParsingException(std::string(
-                "Comparision requires both operands to be either pointer to object or to be of real type, but they were of type")
-              + lhs->getType()->toString() + " and "
-              + rhs->getType()->toString()
-              , this->pos());
-        }
-      }
+      setConstantValue(l < r);
       break;
     case PunctuatorType::EQUAL:
+      setConstantValue(l == r);
+      break;
     case PunctuatorType::NEQUAL:
-      this->type = make_shared<IntDeclaration>();
-      if (hasArithmeticType(lhs) && hasArithmeticType(rhs)) {
-        // TODO: apply usual conversions
-        this->type = make_shared<IntDeclaration>();
-      } else {
-        auto lhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(lhs->getType());
-        auto rhs_as_ptr = dynamic_pointer_cast<PointerDeclaration>(rhs->getType());
-        /* either both has to be pointers, or one has to be a pointer and the
-         * othe one a null pointer constant (6.5.9 2)
-         */
-        if (lhs_as_ptr && rhs_as_ptr) {
-          auto lpointee = lhs_as_ptr->pointee();
-          auto rpointee = rhs_as_ptr->pointee();
-          // one operand is a pointer to an object type and the other is a 
-          // pointer to a qualified or unqualified version of void
-          if (!(  (isObjectType(lpointee) && rpointee->type() == Semantic::Type::VOID)
-              || (isObjectType(rpointee) && lpointee->type() == Semantic::Type::VOID))) {
-            // both operands are pointers to qualified or unqualified versions 
-            // of compatible types
-            if (!compareTypes(lpointee, rpointee)) {
-              ostringstream errmsg;
-              errmsg << "Operands of equality operator are not compatible! Types were: "
-                << lhs->getType()->toString() << " and "
-                << rhs->getType()->toString();
-              throw ParsingException(errmsg.str(), *operator_position);
-            }
-          }
-        } else
-        if (   (lhs_as_ptr && isNullPtrConstant(rhs))
-            || (rhs_as_ptr && isNullPtrConstant(lhs))) {
-          if (isNullPtrConstant(rhs)) {
-            rhs->setType(lhs_as_ptr);
-          } else {
-            lhs->setType(rhs_as_ptr);
-          }
-          this->type = make_shared<IntDeclaration>();
-        } else {
-          throw ParsingException(std::string("Comparision requires both operands to be either pointer to object or to be of arithmetic type."), this->pos());
-        }
-      }
+      setConstantValue(l != r);
       break;
     case PunctuatorType::LAND:
     case PunctuatorType::LOR:
-      if (!hasScalarType(lhs)) {
-        throw ParsingException(std::string("Logical operator requires operands with scalar type, but left operand is ") + (lhs->getType() ? lhs->getType()->toString() : "INITIALIZE ME!"), lhs->pos());
-      }
-      if (!hasScalarType(rhs)) {
-        throw ParsingException(std::string("Logical operator requires operands with scalar type, but right operand is ") + (rhs->getType() ? rhs->getType()->toString() : "INITIALIZE ME!"), lhs->pos());
-      }
-      this->type = make_shared<IntDeclaration>();
+      setConstantValue(r != 0);
       break;
-    case PunctuatorType::ASSIGN:
-      {
-      /* 6.5.16 $2:
-       * An assignment operator shall have a modifiable lvalue as its left operand.
-       * WARNING: We currently don't have non-modifiable lvalues, because string
-       * literals are not lvalues in our implementation and const does not exist;
-       * as soon as this changes, the check below is not sufficiant enough
-       */
-      if (!lhs->can_be_lvalue()) {
-        throw ParsingException("The left operand of an assignment must be a lvalue",
-             *operator_position);
-      }
-      /* FIXME: this is probably wrong, allowing too much (can we really apply
-       * the usual conversions here?)!
-       * Check the legality of the following
-       *  lhs is pointer, rhs is int => not allowed
-       *  lhs is pointer, rhs is null pointer constant => done
-       *  lhs is int, rhs is pointer => not allowed
-       *  more?
-       */
-      auto valid = validAssignment(lhs->getType(), rhs);
-      if (!valid) {
-        std::stringstream errmsg;
-        errmsg << "Assignment invalid, <descriptive error messages here>!\n"
-               << "lhs has type " << lhs->getType()->toString() << '\n'
-               << "rhs has type " << rhs->getType()->toString() << '\n';
-        throw ParsingException(errmsg.str(), pos);
-      }
-      this->type = lhs->getType();
-      break;
-      }
     default:
-      throw ParsingException(std::string() + "Implement this! " + Lexing::PunctuatorType2String(op), pos);
       break;
   }
 }
@@ -347,13 +594,27 @@ BinaryExpression::BinaryExpression(SubExpression lhs,
 UnaryExpression::UnaryExpression(PunctuatorType op, SubExpression operand, Pos pos) :
   Expression(pos), operand(operand), op(op)
 {
+}
+
+void UnaryExpression::analyze(SemanticTree & semanticTree)
+{
+  operand->analyze(semanticTree);
+  auto & rule = operatorRules().unary[OperatorRules::index(op)];
+  if (rule.hasForms()) {
+    auto & form = matchForm(rule, operand, nullptr, pos());
+    this->type = resultType(form.result, operand);
+    foldConstant();
+    return;
+  }
   switch (op) {
     // 6.5.3.2 has some strange stuff in section 3 about & and *'s interplay
     case PunctuatorType::STAR:
+      {
       /* to understand this 
        * http://stackoverflow.com/questions/6893285/why-do-all-these-crazy-function-pointer-definitions-all-work-what-is-really-goi
        * is useful (though not a replacement for the standard) */
-      if (auto optype = dynamic_pointer_cast<PointerDeclaration>(operand->getType()))  {
+      auto operand_type = operand->getType();
+      if (auto optype = asPointer(operand_type))  {
         // dereferencing a pointer yields the type of the pointee
         this->type = optype->pointee();
         if (isCompleteObjectType(this->type)) {
@@ -364,18 +625,19 @@ UnaryExpression::UnaryExpression(PunctuatorType op, SubExpression operand, Pos p
           this->m_can_be_lvalue = true;
         } else if (isIncompleteType(optype->pointee())) {
           throw ParsingException("Cannot dereference pointer to incomplete type "
-                                 + optype->pointee()->toString(), pos);
+                                 + optype->pointee()->toString(), pos());
         }
-      } else if (auto optype = dynamic_pointer_cast<FunctionDeclaration>(operand->getType())) {
+      } else if (operandClass(operand_type) == FUNCTION) {
         // function  is convertible to pointer to function
         // when dereferenced, we get the function again 
-        this->type = optype;
+        this->type = operand_type;
       } else {
         throw ParsingException(std::string("Cannot dereference ") 
-                               + (operand->getType() ? operand->getType()->toString() : "INITIALIZE ME!"),
+                               + (operand_type ? operand_type->toString() : "INITIALIZE ME!"),
                                operand->pos());
       }
       break;
+      }
     case PunctuatorType::AMPERSAND:
       {
       // TODO: check that operand is lvalue, function designator, or operand of
@@ -386,6 +648,7 @@ UnaryExpression::UnaryExpression(PunctuatorType op, SubExpression operand, Pos p
       auto valid = false;
       if (operand->can_be_lvalue() && hasObjectType(operand)) {
         valid = true;
+        operand->markAddressTaken();
       } else if (operand->getType()->type() == Semantic::Type::FUNCTION) {
         //2) a function designator
         valid = true;
@@ -409,59 +672,53 @@ UnaryExpression::UnaryExpression(PunctuatorType op, SubExpression operand, Pos p
       }
       break;
       }
+    default:
+      throw ParsingException(std::string() + "Implement this! " + Lexing::PunctuatorType2String(op), pos());
+      break;
+  }
+}
+
+void UnaryExpression::foldConstant()
+{
+  switch (op) {
     case PunctuatorType::MINUS:
-      if (!hasArithmeticType(operand)) {
-        ostringstream errmsg;
-        errmsg << "Operator - requires an arithmetic type, but got "
-               <<  operand->getType()->toString()
-               << "\n";
-        throw ParsingException(errmsg.str(), operand->pos());
-      } else {
-        this->type = promoteType(operand->getType());
+      if (operand->hasConstantValue() && foldsLikeInt(this->type)) {
+        setConstantValue(wrap(-static_cast<int64_t>(operand->constantValue())));
       }
       break;
     case PunctuatorType::NOT:
-      if (!hasScalarType(operand)) {
-        throw ParsingException("Operator '!' requires an operand of scalar type", operand->pos());
+      if (operand->hasConstantValue()) {
+        setConstantValue(!operand->constantValue());
       }
-      this->type = make_shared<IntDeclaration>();
-     break;
-    case PunctuatorType::SIZEOF:
-     if (dynamic_pointer_cast<FunctionDeclaration>(operand->getType())) {
-        throw ParsingException("Illegal application of 'sizeof' to a function type", operand->pos());
-     }
-     // in real C, it would be size_t, but we don't have that one
-     this->type = make_shared<IntDeclaration>();
-     break;
+      break;
+    case PunctuatorType::SIZEOF: {
+      // the operand of sizeof is never evaluated
+      auto size = constantSize(operand->getType());
+      if (size >= 0) {
+        setConstantValue(size);
+      }
+      break;
+                                 }
     default:
-      throw ParsingException(std::string() + "Implement this! " + Lexing::PunctuatorType2String(op), pos);
       break;
   }
 }
 
-VariableUsage::VariableUsage(std::string name, Pos pos, 
-                             SemanticTreeNode semanticTree) 
-  : Expression(pos), name(name), semanticTree(semanticTree) {
+VariableUsage::VariableUsage(std::string name, Pos pos)
+  : Expression(pos), name(name) {
     this->m_can_be_lvalue = true;
   }
 
-SemanticDeclarationNode VariableUsage::getType() {
-  if (!this->type) {
-    this->type = semanticTree->lookUpType(name, pos());
-  }
-  return this->type;
-
-}
-
-void VariableUsage::checkSemanticConstraints() {
+void VariableUsage::analyze(SemanticTree & semanticTree) {
   // check if the variable is declared
-  this->getType();
+  this->type = semanticTree.lookUpType(name, pos());
+  this->type->used = true;
 }
 
-SemanticDeclarationNode VariableUsage::getType(SubSemanticNode s) {
+SemanticDeclarationNode VariableUsage::getType(SubSemanticNode s, unsigned &index) {
   if (!this->type) {
     try {
-      this->type = s->getNode(this->name);
+      this->type = s->getNode(this->name, index);
     } catch (const SemanticException & e) {
         throw ParsingException(std::string("Struct has no member " + name), this->pos());
     }
@@ -470,6 +727,10 @@ SemanticDeclarationNode VariableUsage::getType(SubSemanticNode s) {
 
 }
 
+void VariableUsage::markAddressTaken() {
+  this->type->addressTaken = true;
+}
+
 namespace {
   char unescape(const char c) {
     switch(c) {
@@ -524,7 +785,7 @@ Literal::Literal(std::string name, Pos pos)
   }
   unescaped.pop_back(); // to remove the trailing "
   this->type = make_shared<ArrayDeclaration>(
-      make_shared<CharDeclaration>(),  // type
+      types().charType(),  // type
       unescaped.size() + 1 // one more than the size to store '\0'
       );
 }
@@ -537,7 +798,7 @@ Constant::Constant(std::string name, Pos pos, Lexing::ConstantType ct)
       {
       // 6.4.4.4 $10
       // An integer character constant has type int. 
-      this->type = make_shared<IntDeclaration>();
+      this->type = types().intType();
       // strip leading and trailing '
       unescaped.reserve(1);
       auto it = name.cbegin();
@@ -551,20 +812,36 @@ Constant::Constant(std::string name, Pos pos, Lexing::ConstantType ct)
         ++it;
       }
       unescaped.pop_back(); // to remove the trailing '
+      // the code generator emits the constant as a char
+      setConstantValue(static_cast<char>(unescaped.at(0)));
       break;
       }
     case Lexing::ConstantType::NULLPOINTER:
       // One can't decide which type a nullpointer has without knowing in which
       // context it is used
-      this->type = make_shared<NullDeclaration>();
+      this->type = types().nullType();
+      setConstantValue(0);
       break;
     case Lexing::ConstantType::INT:
     default:
-      this->type = make_shared<IntDeclaration>();
+      this->type = types().intType();
+      try {
+        setConstantValue(std::stoi(name));
+      } catch (std::out_of_range & e) {
+        // 6.4.4.1: the constant has the first type its value fits into; the
+        // folded constants are ints, so it is left to the code generator, which
+        // also reports values beyond long
+        this->type = types().longType();
+      }
       break;
   }
 }
 
+bool Constant::hasConstantValue() {
+  // a null pointer constant might have been converted to a pointer
+  return m_has_constant_value && operandClass(this->type) == ARITHMETIC;
+}
+
 void Expression::setType(SemanticDeclarationNode s) {
   this->type = s;
 }
@@ -574,6 +851,14 @@ FunctionCall::FunctionCall(SubExpression funcName,
                            std::vector<SubExpression> arguments, Pos pos)
         : Expression(pos), funcName(funcName), arguments(arguments) 
 {
+}
+
+void FunctionCall::analyze(SemanticTree & semanticTree)
+{
+  funcName->analyze(semanticTree);
+  for (auto & argument : arguments) {
+    argument->analyze(semanticTree);
+  }
   auto type = funcName->getType();
   if (type->type() == Semantic::Type::POINTER) {
     type = std::static_pointer_cast<PointerDeclaration>(type)->pointee();
@@ -605,12 +890,12 @@ FunctionCall::FunctionCall(SubExpression funcName,
       errmsg  << function->toString() << " requires "
         << expected_parameter.size() << " parameters, but "
         << arguments.size() << " parameters were given.";
-      throw ParsingException(errmsg.str(), pos);
+      throw ParsingException(errmsg.str(), pos());
     }
   } else {
     throw ParsingException(std::string("Trying to call ") 
         + (funcName->getType() ? funcName->getType()->toString() : "INITIALIZE ME!")
-        + " which is not a function", pos);
+        + " which is not a function", pos());
   }
 }
 
@@ -620,6 +905,13 @@ TernaryExpression::TernaryExpression(SubExpression condition,
                                      Pos pos)
      : Expression(pos), condition(condition), lhs(lhs), rhs(rhs)
 {
+}
+
+void TernaryExpression::analyze(SemanticTree & semanticTree)
+{
+  condition->analyze(semanticTree);
+  lhs->analyze(semanticTree);
+  rhs->analyze(semanticTree);
   std::ostringstream errmsg;
   // 6.5.15: conditional operator
   //The first operand shall have scalar type.
@@ -709,7 +1001,20 @@ TernaryExpression::TernaryExpression(SubExpression condition,
   if (!valid) {
     errmsg << "Second and third operand of conditional operator have unsuiting types "
            << lhs_type->toString() << " and " << rhs_type->toString();
-    throw ParsingException(errmsg.str(), pos);
+    throw ParsingException(errmsg.str(), pos());
+  }
+  foldConstant();
+}
+
+void TernaryExpression::foldConstant()
+{
+  // only the selected operand is evaluated, so the other one needn't be constant
+  if (operandClass(this->type) != ARITHMETIC || !condition->hasConstantValue()) {
+    return;
+  }
+  auto selected = condition->constantValue() ? lhs : rhs;
+  if (selected->hasConstantValue()) {
+    setConstantValue(selected->constantValue());
   }
 }
 
@@ -719,6 +1024,12 @@ BasicType::BasicType(std::string type, Pos pos) : Type(pos)
     this->type = INT;
   } else if (type == "char") {
     this->type = CHAR;
+  } else if (type == "long") {
+    this->type = LONG;
+  } else if (type == "unsigned int") {
+    this->type = UNSIGNED;
+  } else if (type == "unsigned long") {
+    this->type = UNSIGNED_LONG;
   } else if (type == "void") {
     this->type = VOID;
   } else {
@@ -731,12 +1042,19 @@ string BasicType::toString() {
     return "int";
   } else if (type == CHAR) {
     return "char";
+  } else if (type == LONG) {
+    return "long";
+  } else if (type == UNSIGNED) {
+    return "unsigned int";
+  } else if (type == UNSIGNED_LONG) {
+    return "unsigned long";
   } else { // if (type == VOID) {
     return "void";
   }
 }
 
-StructType::StructType(std::string name, Pos pos) : Type(pos), name(name) {
+StructType::StructType(std::string name, Pos pos, bool forward)
+  : Type(pos), name(name), forward(forward) {
   // default string is empty
   mycontent = std::vector<std::pair<TypeNode, SubDeclarator>> ();
   content = StructContent();
@@ -749,12 +1067,14 @@ StructType::StructType(Pos pos) : Type(pos) {
   content = StructContent();
   mycontent = std::vector<std::pair<TypeNode, SubDeclarator>> ();
   hasDeclaration = false;
+  forward = false;
 }
 
 StructType::StructType(std::string name, StructContent strcontent, Pos pos)
   : Type(pos), name(name), content(strcontent) {
   mycontent = std::vector<std::pair<TypeNode, SubDeclarator>> ();
   hasDeclaration = true;
+  forward = false;
 
   for(auto cont : strcontent) {
     if (!cont.second.empty()) {
@@ -771,6 +1091,32 @@ std::string StructType::toString()
   return name;
 }
 
+void StructType::analyze(SemanticTree & semanticTree)
+{
+  // anonymous structs got a name starting with @ from the parser
+  auto tag = "@" + name;
+  if (hasDeclaration) {
+    semanticTree.addChild(pos(), tag);
+    for (auto & member : content) {
+      member.first->analyze(semanticTree);
+      for (auto & declarator : member.second) {
+        if (declarator.first) {
+          declarator.first->analyze(semanticTree);
+          semanticTree.addDeclaration(member.first, declarator.first,
+                                      declarator.first->pos());
+        }
+        if (declarator.second) {
+          declarator.second->analyze(semanticTree);
+        }
+      }
+    }
+    semanticTree.goUp();
+  } else if (forward && !semanticTree.hasStructDeclaration(tag)) {
+    semanticTree.addChild(pos(), tag, true);
+    semanticTree.goUp();
+  }
+}
+
 bool StructType::isStruct() {
   return true;
 }
@@ -791,19 +1137,75 @@ CompoundStatement::CompoundStatement(std::vector<BlockItem> subStatements, Pos p
 
 }
 
+void CompoundStatement::analyze(SemanticTree & semanticTree)
+{
+  semanticTree.addChild(pos());
+  analyzeItems(semanticTree);
+  semanticTree.goUp();
+}
+
+void CompoundStatement::analyzeItems(SemanticTree & semanticTree)
+{
+  for (auto & item : subStatements) {
+    item->analyze(semanticTree);
+  }
+}
+
+bool CompoundStatement::containsLabel()
+{
+  for (auto & item : subStatements) {
+    auto statement = std::dynamic_pointer_cast<Statement>(item);
+    if (statement && statement->containsLabel()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CompoundStatement::containsCaseLabel()
+{
+  for (auto & item : subStatements) {
+    auto statement = std::dynamic_pointer_cast<Statement>(item);
+    if (statement && statement->containsCaseLabel()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 SelectionStatement::SelectionStatement(SubExpression ex,
     SubStatement ifStat,
     Pos pos) : Statement(pos)
 {
   expression = ex;
-  ex->checkSemanticConstraints();
-  if (!hasScalarType(ex)) {
+  ifStatement = ifStat;
+}
+
+void SelectionStatement::analyze(SemanticTree & semanticTree)
+{
+  expression->analyze(semanticTree);
+  ifStatement->analyze(semanticTree);
+  if (elseStatement) {
+    elseStatement->analyze(semanticTree);
+  }
+  if (!hasScalarType(expression)) {
     throw ParsingException(
         "Controlling expression of selection statement must have scalar type",
-        pos
+        pos()
         );
   };
-  ifStatement = ifStat;
+}
+
+bool SelectionStatement::containsLabel()
+{
+  return ifStatement->containsLabel()
+    || (elseStatement && elseStatement->containsLabel());
+}
+
+bool SelectionStatement::containsCaseLabel()
+{
+  return ifStatement->containsCaseLabel()
+    || (elseStatement && elseStatement->containsCaseLabel());
 }
 
 // use delegating constructor
@@ -817,16 +1219,24 @@ SelectionStatement::SelectionStatement(
 }
 
 
-Declaration::Declaration(TypeNode t, SubDeclarator declarator, Pos pos, shared_ptr<SemanticTree> semanticTree)
-  : AstNode(pos), type(t),declarator(declarator), semanticTree(semanticTree) {
-    declNode = semanticTree->addDeclaration(type, declarator, pos);
-}
+Declaration::Declaration(TypeNode t, SubDeclarator declarator, Pos pos)
+  : AstNode(pos), type(t),declarator(declarator) {}
 
 
 Declaration::Declaration(TypeNode t, Pos pos)
   : AstNode(pos), type(t){}
 
 
+void Declaration::analyze(SemanticTree & semanticTree)
+{
+  type->analyze(semanticTree);
+  if (declarator) {
+    declarator->analyze(semanticTree);
+    declNode = semanticTree.addDeclaration(type, declarator, pos());
+  }
+}
+
+
 SemanticDeclarationNode Declaration::getSemanticNode() 
 {
   return declNode; 
@@ -837,39 +1247,74 @@ FunctionDefinition::FunctionDefinition(TypeNode type,
                         SubDeclarator declarator,
                         SubCompoundStatement compoundStatement,
                         Pos pos,
-                        shared_ptr<SemanticTree> semanticTree
+                        shared_ptr<SemanticTree> semanticTree,
+                        bool isStatic
                         )
-  : ExternalDeclaration(type, declarator, pos, semanticTree, false),
+  : ExternalDeclaration(type, declarator, pos, semanticTree, false, isStatic),
     compoundStatement(compoundStatement)
 {
 }
 
+void FunctionDefinition::analyze(SemanticTree & semanticTree)
+{
+  enterBody(semanticTree);
+  analyzeBody(semanticTree);
+}
+
+void FunctionDefinition::enterBody(SemanticTree & semanticTree)
+{
+  semanticTree.setCurrentFunction(declNode);
+  semanticTree.addChild(compoundStatement->pos());
+  // add variables for the function
+  auto paramList = declarator->getNextParameter();
+  if (!paramList.empty()) {
+    auto fu = static_pointer_cast<FunctionDeclaration>(declNode);
+    std::vector<Parsing::SemanticDeclarationNode> params;
+    for (auto par : paramList) {
+      auto pa = semanticTree.addDeclaration(par->getType(), par->getDeclarator(),
+                                            compoundStatement->pos());
+      if (pa) {
+        params.push_back(pa);
+      }
+    }
+    fu->rebindParameters(params);
+  }
+}
+
+void FunctionDefinition::analyzeBody(SemanticTree & semanticTree)
+{
+  // the body shares the scope of the parameters
+  compoundStatement->analyzeItems(semanticTree);
+  semanticTree.goUp();
+  semanticTree.unsetCurrentFunction();
+}
+
 ExternalDeclaration::ExternalDeclaration(TypeNode type,
                         SubDeclarator declarator,
                         Pos pos,
                         shared_ptr<SemanticTree> semanticTree,
-                        bool assign
+                        bool forwardFunction,
+                        bool isStatic
                         )
   : AstNode(pos), type(type), declarator(declarator),
-    semanticTree(semanticTree)
+    semanticTree(semanticTree), isStatic(isStatic)
 {
-  if (assign) {
-    if (semanticTree) {
-      declNode = semanticTree->addDeclaration(type, declarator, pos);
-      if (!Semantic::isValidType(declNode)) {
-        throw ParsingException("Illegal type: " + declNode->toString(), pos);
-      }
-    }
-  }else {
-    auto name = declarator->getIdentifier();
-    declNode = semanticTree-> lookUpType(name, pos);
+  type->analyze(*semanticTree);
+  declarator->analyze(*semanticTree);
+  declNode = semanticTree->addDeclaration(type, declarator, pos, forwardFunction);
+  if (!Semantic::isValidType(declNode)) {
+    throw ParsingException("Illegal type: " + declNode->toString(), pos);
+  }
+  // redeclarations share declNode and keep the linkage of the first
+  // declaration; a static one cannot follow one with external linkage
+  // (C11 6.2.2p7)
+  if (!declNode->linkageDecided) {
+    declNode->linkageDecided = true;
+    declNode->internalLinkage = isStatic;
+  } else if (isStatic && !declNode->internalLinkage) {
+    throw ParsingException(declarator->getIdentifier()
+        + " was declared with external linkage before", pos);
   }
-
-//  std::cout<<"NAME: "<<declarator->getIdentifier()<<std::endl;
-//  std::cout<<"Node: "<<declNode->toString()<<std::endl;
-
-  // add the type
-  
 }
 
 ExternalDeclaration::ExternalDeclaration(TypeNode type, Pos pos
@@ -877,6 +1322,7 @@ ExternalDeclaration::ExternalDeclaration(TypeNode type, Pos pos
 )
   : AstNode(pos), type(type), semanticTree(semanticTree)
 {
+  type->analyze(*semanticTree);
   if(type->isStruct() && type->containsDeclaration()) {
     declNode = semanticTree->createType(type, pos);
   }
@@ -888,6 +1334,19 @@ bool ExternalDeclaration::isFunction()
   return false;
 }
 
+void ExternalDeclaration::checkDefinition()
+{
+  if (!declNode || declNode->type() != Semantic::Type::FUNCTION
+      || !declNode->internalLinkage || !declNode->used) {
+    return;
+  }
+  auto name = declarator->getIdentifier();
+  if (!semanticTree->isDefinedFunction(name)) {
+    throw ParsingException("static function " + name
+        + " is used but never defined", pos());
+  }
+}
+
 
 SemanticDeclarationNode ExternalDeclaration::getSemanticNode()
 {
@@ -910,6 +1369,13 @@ TranslationUnit::TranslationUnit(
   }
 }
 
+void TranslationUnit::checkDefinitions()
+{
+  for (auto & declaration : externalDeclarations) {
+    declaration->checkDefinition();
+  }
+}
+
 Parameter::Parameter(TypeNode type, SubDeclarator declarator, Pos pos)
   : AstNode(pos), type(type), declarator(declarator) {
   
@@ -920,6 +1386,16 @@ Parameter::Parameter(TypeNode type, Pos pos)
   
 }
 
+void Parameter::analyze(SemanticTree & semanticTree)
+{
+  // parameters are not declared anywhere, but their types might declare
+  // structs
+  type->analyze(semanticTree);
+  if (declarator) {
+    declarator->analyze(semanticTree);
+  }
+}
+
 //DirectDeclaratorHelp::DirectDeclaratorHelp(Pos pos) 
   //: AstNode(pos)
 //{
@@ -946,42 +1422,69 @@ DirectDeclaratorHelp::DirectDeclaratorHelp(SubIdentifierList idList, Pos pos)
   helperType = IDENTIFIERLIST;
 }
 
+void DirectDeclaratorHelp::analyze(SemanticTree & semanticTree)
+{
+  for (auto & parameter : paramList) {
+    parameter->analyze(semanticTree);
+  }
+}
+
 
 SizeOfExpression::SizeOfExpression(std::pair<TypeNode, SubDeclarator> operand, Pos pos)
   : Expression(pos), operand(operand) 
 {
+}
+
+void SizeOfExpression::analyze(SemanticTree & semanticTree)
+{
+  operand.first->analyze(semanticTree);
+  if (operand.second) {
+    operand.second->analyze(semanticTree);
+  }
   // TODO: do we need any further checks here? Or is the operand guarantueed to be
   // valid when the constructor is called
-  this->type = make_shared<IntDeclaration>();
-  this->sem_type = SemanticForest::filename2SemanticTree(pos.name)->helpConvert(
-      operand.first, operand.second, SemanticDeclarationNode{}, pos);
+  this->type = types().unsignedLongType();
+  this->sem_type = semanticTree.helpConvert(
+      operand.first, operand.second, SemanticDeclarationNode{}, pos());
+  auto size = constantSize(this->sem_type);
+  if (size >= 0) {
+    setConstantValue(size);
+  }
 }
 
 ReturnStatement::ReturnStatement(Pos pos) : JumpStatement(pos) 
 {
-  // single return without expression -> return type must be void
-  auto actual_type = make_shared<VoidDeclaration>();
-  auto function_type = SemanticForest::filename2SemanticTree(this->pos().name)->currentFunction();
-  // extract the return type from it
-  auto expected_type = std::dynamic_pointer_cast<FunctionDeclaration>(function_type)->returnType();
-  if (!compareTypes(actual_type, expected_type)) {
-    throw ParsingException("void function should not return a value", pos);
-  }
 }
 
 ReturnStatement::ReturnStatement(SubExpression ex, Pos pos) 
   : JumpStatement(pos), expression(ex)
 {
-  // Get the type of the expression which we are returning
-  auto actual_type = ex->getType();
-  verifyReturnType(ex);
 }
 
-void ReturnStatement::verifyReturnType(SubExpression returnExp) {
+void ReturnStatement::analyze(SemanticTree & semanticTree)
+{
+  if (expression) {
+    expression->analyze(semanticTree);
+    verifyReturnType(expression, semanticTree);
+    return;
+  }
+  // single return without expression -> return type must be void
+  auto actual_type = types().voidType();
+  auto function_type = semanticTree.currentFunction();
+  // extract the return type from it
+  auto expected_type = std::static_pointer_cast<FunctionDeclaration>(function_type)->returnType();
+  if (!compareTypes(actual_type, expected_type)) {
+    throw ParsingException("void function should not return a value", pos());
+  }
+}
+
+void ReturnStatement::verifyReturnType(SubExpression returnExp,
+                                       SemanticTree & semanticTree) {
   // Get the type of the function which in which we ar
-  auto function_type = SemanticForest::filename2SemanticTree(this->pos().name)->currentFunction();
+  auto function_type = semanticTree.currentFunction();
   // extract the return type from it
-  auto expected_type = std::dynamic_pointer_cast<FunctionDeclaration>(function_type)->returnType();
+  auto expected_type = std::static_pointer_cast<FunctionDeclaration>(function_type)->returnType();
+  this->returnType = expected_type;
   if (!validAssignment(expected_type, returnExp)) {
     throw ParsingException(std::string("A ")
         + returnExp->getType()->toString()
@@ -994,29 +1497,141 @@ void ReturnStatement::verifyReturnType(SubExpression returnExp) {
 
 ContinueStatement::ContinueStatement(Pos pos) : JumpStatement(pos) {}
 
+void ContinueStatement::analyze(SemanticTree & semanticTree)
+{
+  if (!semanticTree.isInLoop()) {
+    throw ParsingException("continue must be inside a loop", pos());
+  }
+}
+
 BreakStatement::BreakStatement(Pos pos) : JumpStatement(pos) {}
 
+void BreakStatement::analyze(SemanticTree & semanticTree)
+{
+  if (!semanticTree.isBreakable()) {
+    throw ParsingException("break must be inside a loop or switch", pos());
+  }
+}
+
 GotoStatement::GotoStatement(std::string label, Pos pos) 
   : JumpStatement(pos), label(label) {}
 
+void GotoStatement::analyze(SemanticTree & semanticTree)
+{
+  semanticTree.addGotoLabel(label, pos());
+}
+
 IterationStatement::IterationStatement(SubExpression ex,
     SubStatement st,
     IterationEnum k,
     Pos pos)
   : Statement(pos), expression(ex), statement(st), kind(k) 
 {
-  if (!hasScalarType(expression))   {
+}
+
+IterationStatement::IterationStatement(SubExpression init,
+    SubExpression ex,
+    SubExpression step,
+    SubStatement st,
+    Pos pos)
+  : Statement(pos), expression(ex), statement(st), kind(IterationEnum::FOR),
+    init(init), step(step)
+{
+}
+
+void IterationStatement::analyze(SemanticTree & semanticTree)
+{
+  // we can have break and continue here
+  semanticTree.increaseLoopDepth();
+  if (kind == IterationEnum::DOWHILE) {
+    statement->analyze(semanticTree);
+    expression->analyze(semanticTree);
+  } else {
+    if (init) {
+      init->analyze(semanticTree);
+    }
+    // a for loop without a condition runs until it is left
+    if (expression) {
+      expression->analyze(semanticTree);
+    }
+    if (step) {
+      step->analyze(semanticTree);
+    }
+    statement->analyze(semanticTree);
+  }
+  semanticTree.decreaseLoopDepth();
+  if (expression && !hasScalarType(expression))   {
     throw ParsingException(
         "Controlling expression of an iteration statement must have scalar type",
-        pos
+        pos()
+        );
+  }
+}
+
+bool IterationStatement::containsLabel()
+{
+  return statement && statement->containsLabel();
+}
+
+bool IterationStatement::containsCaseLabel()
+{
+  return statement && statement->containsCaseLabel();
+}
+
+
+SwitchStatement::SwitchStatement(SubExpression ex, SubStatement st, Pos pos)
+  : Statement(pos), expression(ex), statement(st) {}
+
+void SwitchStatement::analyze(SemanticTree & semanticTree)
+{
+  expression->analyze(semanticTree);
+  if (!hasIntegerType(expression)) {
+    throw ParsingException(
+        "Controlling expression of a switch statement must have integer type",
+        pos()
         );
   }
+  semanticTree.enterSwitch();
+  statement->analyze(semanticTree);
+  semanticTree.leaveSwitch();
+}
+
+bool SwitchStatement::containsLabel()
+{
+  return statement->containsLabel();
 }
 
+CaseStatement::CaseStatement(SubExpression ex, SubStatement st, Pos pos)
+  : Statement(pos), expression(ex), statement(st) {}
+
+CaseStatement::CaseStatement(SubStatement st, Pos pos)
+  : Statement(pos), statement(st) {}
+
+void CaseStatement::analyze(SemanticTree & semanticTree)
+{
+  if (expression) {
+    expression->analyze(semanticTree);
+    if (!hasIntegerType(expression) || !expression->hasConstantValue()) {
+      throw ParsingException("case label must be an integer constant", pos());
+    }
+    semanticTree.addCaseLabel(expression->constantValue(), pos());
+  } else {
+    semanticTree.addDefaultLabel(pos());
+  }
+  statement->analyze(semanticTree);
+}
 
 LabeledStatement::LabeledStatement(std::string str, SubStatement st, Pos pos)
   : Statement(pos), name(str), statement(st) {}
 
+void LabeledStatement::analyze(SemanticTree & semanticTree)
+{
+  statement->analyze(semanticTree);
+  if (!semanticTree.addLabel(name)) {
+    throw ParsingException("The label " + name + " is already defined", pos());
+  }
+}
+
 
 
 
@@ -1024,6 +1639,13 @@ ExpressionStatement::ExpressionStatement(Pos pos) : Statement(pos) {}
 ExpressionStatement::ExpressionStatement(SubExpression ex, Pos pos) 
   : Statement(pos), expression(ex) {}
 
+void ExpressionStatement::analyze(SemanticTree & semanticTree)
+{
+  if (expression) {
+    expression->analyze(semanticTree);
+  }
+}
+
 bool Parameter::hasDeclarator() {
   return declarator ? true : false;
 }
@@ -1106,6 +1728,17 @@ DeclaratorDirectDeclarator::DeclaratorDirectDeclarator(SubDeclarator d,
         Pos pos) 
   : DirectDeclarator(pos), declarator(d) {}
 
+void DeclaratorDirectDeclarator::analyze(SemanticTree & semanticTree)
+{
+  if (declarator) {
+    declarator->analyze(semanticTree);
+  }
+  // the parser stores the parameter lists in reverse order
+  for (auto it = help.rbegin(); it != help.rend(); ++it) {
+    (*it)->analyze(semanticTree);
+  }
+}
+
 
 
 
@@ -1146,6 +1779,14 @@ IdentifierDirectDeclarator::IdentifierDirectDeclarator(std::string str,
 IdentifierDirectDeclarator::IdentifierDirectDeclarator(std::string str,
     Pos pos) : DirectDeclarator(pos), identifier(str) {}
 
+void IdentifierDirectDeclarator::analyze(SemanticTree & semanticTree)
+{
+  // the parser stores the parameter lists in reverse order
+  for (auto it = help.rbegin(); it != help.rend(); ++it) {
+    (*it)->analyze(semanticTree);
+  }
+}
+
 
 std::vector<ParameterNode> IdentifierDirectDeclarator::getParameter() { 
   if (help.size() == 0) {
@@ -1172,5 +1813,14 @@ IdentifierList::IdentifierList(std::vector<std::string > list, Pos pos)
   : AstNode(pos), nameList(list) {}
 
 
-Declarator::Declarator(int cnt, SubDirectDeclarator ast, Pos pos)
-  : AstNode(pos), pointerCounter(cnt), directDeclarator(ast) {}
+Declarator::Declarator(int cnt, SubDirectDeclarator ast, Pos pos,
+                       bool restrictQualified)
+  : AstNode(pos), pointerCounter(cnt), directDeclarator(ast),
+    restrictQualified(restrictQualified) {}
+
+void Declarator::analyze(SemanticTree & semanticTree)
+{
+  if (directDeclarator) {
+    directDeclarator->analyze(semanticTree);
+  }
+}
@@ -19,6 +19,7 @@
 
 #define EMIT_RVALUE llvm::Value* emit_rvalue(Codegeneration::IRCreator *) override;
 #define EMIT_LVALUE llvm::Value* emit_lvalue(Codegeneration::IRCreator *) override;
+#define SPECULATABLE int speculationCost() override;
 
 namespace Codegeneration {
   class IRCreator;
@@ -37,17 +38,25 @@ class EXPRESSION(BinaryExpression)
                      Pos pos,
                      const Pos* const operator_position = nullptr);
     PPRINTABLE
+    ANALYZABLE
     EMIT_RVALUE
     EMIT_LVALUE
+    SPECULATABLE
     void emit_condition(
         Codegeneration::IRCreator* creator,
         llvm::BasicBlock* trueSuccessor,
         llvm::BasicBlock* falseSuccessor
     )override ;
+    llvm::MDNode* accessTag(Codegeneration::IRCreator* creator) override;
+    void markAddressTaken() override;
   private:
     SubExpression lhs;
     SubExpression rhs;
     PunctuatorType op;
+    Pos operatorPosition;
+    // position of the accessed member for . and ->
+    unsigned memberIndex;
+    void foldConstant();
 };
 
 class EXPRESSION(UnaryExpression)
@@ -57,8 +66,10 @@ class EXPRESSION(UnaryExpression)
        SubExpression operand,
        Pos pos);
   PPRINTABLE
+  ANALYZABLE
   EMIT_LVALUE
   EMIT_RVALUE
+  SPECULATABLE
   void  emit_condition(
         Codegeneration::IRCreator* creator,
         llvm::BasicBlock* trueSuccessor,
@@ -68,23 +79,25 @@ class EXPRESSION(UnaryExpression)
   private:
    SubExpression operand;
    PunctuatorType op;
+   void foldConstant();
 };
 
 class EXPRESSION(VariableUsage)
 {
   public:
-    VariableUsage(std::string name, Pos pos, SemanticTreeNode semanticTree);
-    SemanticDeclarationNode getType() override;
-    void checkSemanticConstraints() override;
+    VariableUsage(std::string name, Pos pos);
+    using Expression::getType;
     // maps a variable name to its type when it is used in the context of a
-    // struct
-    SemanticDeclarationNode getType(SubSemanticNode structContext);
+    // struct and stores its position inside the struct in index
+    SemanticDeclarationNode getType(SubSemanticNode structContext,
+                                    unsigned &index);
+    void markAddressTaken() override;
    PPRINTABLE
+   ANALYZABLE
    EMIT_LVALUE
    EMIT_RVALUE
+   SPECULATABLE
     const std::string name;
-  private:
-    SemanticTreeNode semanticTree;
 };
 
 class EXPRESSION(Literal)
@@ -94,6 +107,7 @@ class EXPRESSION(Literal)
     PPRINTABLE
     EMIT_LVALUE
     EMIT_RVALUE
+    SPECULATABLE
     std::string unescaped;
 
   private:
@@ -106,7 +120,9 @@ class EXPRESSION(Constant)
     Constant(std::string name, Pos pos, Lexing::ConstantType ct);
     PPRINTABLE
     EMIT_RVALUE
+    SPECULATABLE
     void setType(SemanticDeclarationNode s);
+    bool hasConstantValue() override;
 
   private:
     Lexing::ConstantType ct;
@@ -121,6 +137,7 @@ class EXPRESSION(FunctionCall)
                  std::vector<SubExpression> arguments,
                  Pos pos);
     PPRINTABLE
+    ANALYZABLE
     EMIT_RVALUE
 
   private:
@@ -136,8 +153,10 @@ class EXPRESSION(TernaryExpression)
                       SubExpression rhs,
                       Pos);
     PPRINTABLE
+    ANALYZABLE
     EMIT_RVALUE
     EMIT_LVALUE
+    SPECULATABLE
     void emit_condition(
         Codegeneration::IRCreator* creator,
         llvm::BasicBlock* trueSuccessor,
@@ -148,22 +167,24 @@ class EXPRESSION(TernaryExpression)
     SubExpression condition;
     SubExpression lhs;
     SubExpression rhs;
+    void foldConstant();
+    // whether the arms are cheap enough to be lowered into a select
+    bool lowersToSelect();
 };
 
 class ASTNODE(Declaration) {
   public:
-    Declaration(TypeNode t, SubDeclarator declarator, 
-                Pos pos, SemanticTreeNode semanticTree);
+    Declaration(TypeNode t, SubDeclarator declarator, Pos pos);
     Declaration(TypeNode t, Pos pos);
     SemanticDeclarationNode getSemanticNode();
 
     IR_EMITTING
     PPRINTABLE
+    ANALYZABLE
   private:
     TypeNode type;
 
     SubDeclarator declarator;
-    SemanticTreeNode semanticTree;
     SemanticDeclarationNode declNode;
 };
 
@@ -174,7 +195,8 @@ class ASTNODE(ExternalDeclaration) {
                         SubDeclarator declarator,
                         Pos pos,
                         SemanticTreeNode semanticTree,
-                        bool assign = true
+                        bool forwardFunction = true,
+                        bool isStatic = false
                         );
     ExternalDeclaration(TypeNode type, Pos pos,
                         SemanticTreeNode semanticTree);
@@ -183,6 +205,12 @@ class ASTNODE(ExternalDeclaration) {
 
     SemanticDeclarationNode getSemanticNode();
 
+    /*
+     * Throws if this declares a static function which is used, but never
+     * defined; only valid once the whole translation unit was analyzed
+     */
+    void checkDefinition();
+
 
     PPRINTABLE
     IR_EMITTING
@@ -191,6 +219,7 @@ class ASTNODE(ExternalDeclaration) {
     SubDeclarator declarator;
     SemanticTreeNode semanticTree;
     SemanticDeclarationNode declNode;
+    bool isStatic = false;
 };
 
 class FunctionDefinition : public ExternalDeclaration {
@@ -199,11 +228,20 @@ class FunctionDefinition : public ExternalDeclaration {
         SubDeclarator declarator,
         SubCompoundStatement compoundStatement,
         Pos pos,
-        SemanticTreeNode semanticTree
+        SemanticTreeNode semanticTree,
+        bool isStatic = false
         );
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
     bool isFunction() override; 
+    /*
+     * analyze() in two steps: enterBody opens the scope of the body and
+     * declares the parameters in it, analyzeBody checks the body and closes
+     * the scope again
+     */
+    void enterBody(SemanticTree & semanticTree);
+    void analyzeBody(SemanticTree & semanticTree);
 
   private:
     SubCompoundStatement compoundStatement;
@@ -215,6 +253,8 @@ class ASTNODE(TranslationUnit) {
   public:
     TranslationUnit(std::vector<ExternalDeclarationNode> externalDeclarations, 
         Pos pos);
+    // see ExternalDeclaration::checkDefinition
+    void checkDefinitions();
     PPRINTABLE
     IR_EMITTING
   private:
@@ -232,7 +272,9 @@ class TYPE(StructType) {
   // TODO Add content
   public:
     StructType(Pos pos);
-    StructType(std::string name, Pos pos);
+    // forward is set if the struct is used without being defined, which
+    // declares it, unless it has been declared before
+    StructType(std::string name, Pos pos, bool forward = false);
     StructType(std::string name, StructContent content, Pos pos);
 
     bool isStruct() override;
@@ -244,12 +286,14 @@ class TYPE(StructType) {
     std::string toString() override;
 
     PPRINTABLE
+    ANALYZABLE
 
   private:
     std::string name;
     StructContent content;
     std::vector<std::pair<TypeNode, SubDeclarator>> mycontent;
     bool hasDeclaration;
+    bool forward;
 };
 
 typedef std::shared_ptr<StructType> StructNode;
@@ -259,7 +303,9 @@ class EXPRESSION(SizeOfExpression)
   public:
     SizeOfExpression(std::pair<TypeNode, SubDeclarator>, Pos pos);
     PPRINTABLE
+    ANALYZABLE
     EMIT_RVALUE
+    SPECULATABLE
     SemanticDeclarationNode sem_type;
   private:
     std::pair<TypeNode, SubDeclarator> operand;
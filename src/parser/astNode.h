@@ -13,6 +13,9 @@
 /* Allows an easy change of emitIR method */
 #define IR_EMITTING void emitIR(Codegeneration::IRCreator *) override;
 
+/* Nodes whose semantic checks depend on the scope they are in */
+#define ANALYZABLE void analyze(SemanticTree &) override;
+
 /* This macro is used in intermediate classes */
 #define CONS_INTER(X) protected : X(Pos pos) : AstNode(pos){};
 
@@ -37,6 +40,8 @@ namespace Codegeneration {
 }
 
 namespace Parsing {
+  class SemanticTree;
+
   class AstNode
   {
     protected:
@@ -44,6 +49,11 @@ namespace Parsing {
     public:
       virtual ~AstNode() {};
       virtual void prettyPrint(unsigned int) {};
+      /*
+       * Checks the node and its children, declaring what they declare in
+       * the given tree; the parser only builds the nodes
+       */
+      virtual void analyze(SemanticTree &) {};
       Pos inline pos() {return m_pos;}
       virtual void emitIR(Codegeneration::IRCreator *);
     private:
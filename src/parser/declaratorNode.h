@@ -63,6 +63,7 @@ typedef std::shared_ptr<Parameter> ParameterNode;
       bool containsOnlyOneVoidIfSpecified();
        
       PPRINTABLE
+      ANALYZABLE
     private:
         DirectDeclaratorHelpEnum helperType;
         // those are mutually exclusive:
@@ -121,7 +122,8 @@ typedef std::shared_ptr<Parameter> ParameterNode;
 
    class ASTNODE(Declarator) {
     public:
-      Declarator(int cnt, SubDirectDeclarator ast, Pos pos);
+      Declarator(int cnt, SubDirectDeclarator ast, Pos pos,
+                 bool restrictQualified = false);
       std::string getIdentifier() { return (directDeclarator ? directDeclarator->getIdentifier() : "@NAMELESS"); }
       int getCounter() { return pointerCounter; }
       std::vector<ParameterNode> getParameter() { 
@@ -151,6 +153,12 @@ typedef std::shared_ptr<Parameter> ParameterNode;
         return false;
       }
 
+      // whether the declared pointer itself is restrict qualified; the
+      // pointers of a nested declarator are the outer ones
+      bool isRestrict() {
+        return restrictQualified && getPointers().first == pointerCounter;
+      }
+
       std::pair<int,bool> getPointers() {
         if(directDeclarator) {
           auto p =  directDeclarator->getPointers();
@@ -179,11 +187,13 @@ typedef std::shared_ptr<Parameter> ParameterNode;
 
       // get SubDeclarator
       PPRINTABLE
+      ANALYZABLE
     private:
         // always empty
         SubDeclarator empty;
         int pointerCounter;
         SubDirectDeclarator directDeclarator;
+        bool restrictQualified;
   };
 
 
@@ -241,6 +251,7 @@ typedef std::shared_ptr<Parameter> ParameterNode;
       }
 
       PPRINTABLE
+      ANALYZABLE
 
     private:
         SubDeclarator s;
@@ -255,6 +266,7 @@ typedef std::shared_ptr<Parameter> ParameterNode;
           Pos pos);
       DeclaratorDirectDeclarator(SubDeclarator d, Pos pos); 
       PPRINTABLE
+      ANALYZABLE
       virtual std::string getIdentifier() {
         return (declarator ? declarator->getIdentifier() : "@NAMELESS");
       }
@@ -319,6 +331,7 @@ class ASTNODE(Parameter) {
     bool hasName();
     bool isVoid(); // tests whether there is only (void) and not (int, void) or something
     PPRINTABLE
+    ANALYZABLE
   private:
     TypeNode type;
     SubDeclarator declarator;
@@ -9,6 +9,7 @@
 namespace llvm {
   class Value;
   class BasicBlock;
+  class MDNode;
 }
 
 namespace Codegeneration {
@@ -22,12 +23,27 @@ class ASTNODE(Expression)
   protected:
     SemanticDeclarationNode type;
     bool m_can_be_lvalue = false;
+    bool m_has_constant_value = false;
+    int m_constant_value = 0;
+    void setConstantValue(int value) {
+      m_has_constant_value = true;
+      m_constant_value = value;
+    };
     CONS_INTER(Expression)
   public:
-    virtual void checkSemanticConstraints() {};
     virtual SemanticDeclarationNode getType() {return this->type;};
     void setType(SemanticDeclarationNode s);
     virtual bool can_be_lvalue() {return m_can_be_lvalue;};
+    // integer constant expressions are folded during the semantic analysis
+    virtual bool hasConstantValue() {return m_has_constant_value;};
+    int constantValue() {return m_constant_value;};
+    /* Number of instructions needed to evaluate the expression, or -1 if it
+     * must not be evaluated unconditionally, because it has side effects or
+     * may trap; ?: evaluates cheap arms without a branch */
+    virtual int speculationCost() {return hasConstantValue() ? 0 : -1;};
+    /* Called when & is applied to the expression; records on the declaration
+     * of the designated variable that it must stay in memory */
+    virtual void markAddressTaken() {};
     virtual llvm::Value* emit_rvalue(Codegeneration::IRCreator*);
     virtual llvm::Value* emit_lvalue(Codegeneration::IRCreator *);
     virtual void emit_condition(
@@ -35,6 +51,8 @@ class ASTNODE(Expression)
         llvm::BasicBlock* trueSuccessor,
         llvm::BasicBlock* falseSuccessor
     );
+    // the TBAA tag for loads and stores of the object the lvalue designates
+    virtual llvm::MDNode* accessTag(Codegeneration::IRCreator* creator);
     IR_EMITTING
 };
 
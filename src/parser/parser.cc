@@ -4,6 +4,8 @@
 #include <cstdio>
 #include <cctype>
 #include <utility> // for std::move
+#include <atomic>
+#include <thread>
 #include "parser.h"
 #include "../utils/diagnostic.h"
 #include "../utils/debug.h"
@@ -19,11 +21,17 @@ using namespace Parsing;
 
 
 // init parser
-Parser::Parser(FILE* f, char const *name)
+Parser::Parser(FILE* f, char const *name, unsigned semanticWorkers)
   :  m_lexer(unique_ptr<Lexer>(new Lexer(f,name))) ,
-     m_nextsym(m_lexer->getNextToken()), m_lookahead(m_lexer->getNextToken())
+     m_nextsym(m_lexer->getNextToken()), m_lookahead(m_lexer->getNextToken()),
+     context(make_shared<CompilationContext>()),
+     semanticWorkers(semanticWorkers)
 {
-  semanticTree = SemanticForest::filename2SemanticTree(name);
+  semanticTree = context->semanticTree;
+}
+
+shared_ptr<CompilationContext> Parser::compilationContext() {
+  return context;
 }
 
 [[noreturn]] inline void Parser::reportError( Pos pos, std::string msg = "Parsing error") {
@@ -87,11 +95,14 @@ void Parser::expected(std::string expected) {
     reportError(msg);
 }
 
+// whether keyword is the first one of a type specifier
+static bool startsTypeSpecifier(const std::string & keyword) {
+  return    keyword == "void" || keyword == "int" || keyword == "char"
+         || keyword == "long" || keyword == "unsigned" || keyword == "struct";
+}
+
 bool Parser::testTypeSpecifier() {
-  return testType(TokenType::KEYWORD) && (
-    testValue("void") || testValue("int") ||
-    testValue("char") || testValue("struct")
-  );
+  return testType(TokenType::KEYWORD) && startsTypeSpecifier(getNextValue());
 }
 
 std::shared_ptr<Token> Parser::getNextSymbol() {
@@ -128,14 +139,14 @@ bool Parser::testLookAheadP(string val) {
 }
 
 
+bool Parser::testLookAheadK(string val) {
+  return m_lookahead->value() == val &&
+         m_lookahead->type() == TokenType::KEYWORD;
+}
+
 bool Parser::testLookAheadType() {
   return (   m_lookahead->type() == TokenType::KEYWORD
-          && (   m_lookahead->value() == "int"
-              || m_lookahead->value() == "char"
-              || m_lookahead->value() == "void"
-              || m_lookahead->value() == "struct"
-             )
-         );
+          && startsTypeSpecifier(m_lookahead->value()));
 }
 
 bool Parser::testp(PunctuatorType puncutator) {
@@ -167,8 +178,11 @@ std::shared_ptr<Token> Parser::scan() {
 }
 
 AstRoot Parser::parse() {
+  CompilationContext::Activation activation(*context);
   auto tu = translationUnit();
   expect(TokenType::END);
+  analyzeDeferredFunctions();
+  tu->checkDefinitions();
 
   return tu;
 }
@@ -191,6 +205,12 @@ ExternalDeclarationNode Parser::externalDeclaration() {
   // functionDefinition or declaration ?
   OBTAIN_POS();
 
+  // static is the only storage class we support, and only at file scope
+  bool isStatic = testk(KeywordType::STATIC);
+  if (isStatic) {
+    scan();
+  }
+
   auto type = typeSpecifier();
   if (testp(";")) {
     // it was a declaration
@@ -204,7 +224,8 @@ ExternalDeclarationNode Parser::externalDeclaration() {
   if (testp(";")) {
     scan();
     // it was a declaration()
-    return make_shared<ExternalDeclaration>(type, decl, pos, semanticTree);
+    return make_shared<ExternalDeclaration>(type, decl, pos, semanticTree,
+                                            true, isStatic);
   }
 
   // it is a functionDefition!
@@ -214,17 +235,59 @@ ExternalDeclarationNode Parser::externalDeclaration() {
 
   expect(PunctuatorType::LEFTCURLYBRACE);
 
-  auto parameter = decl->getNextParameter();
-
+  auto compStat = compoundStatement();
 
-  auto returnType = semanticTree->addDeclaration(type, decl, pos, false);
-  semanticTree->setCurrentFunction(returnType);
-
-  auto compStat = compoundStatement(parameter);
-  semanticTree->unsetCurrentFunction();
+  auto definition = make_shared<FunctionDefinition>(type, decl, compStat, 
+                                                    pos, semanticTree,
+                                                    isStatic);
+  if (semanticWorkers == 0) {
+    definition->analyze(*semanticTree);
+  } else {
+    // the body sees the file scope as it is now
+    auto scope = semanticTree->fork();
+    definition->enterBody(*scope);
+    deferredFunctions.push_back(DeferredFunction {definition, scope});
+  }
+  return definition;
+}
 
-  return make_shared<FunctionDefinition>(type, decl, compStat, 
-                                          pos, semanticTree);
+/*
+ * Checks the bodies of the deferred function definitions on a pool of
+ * semanticWorkers threads (this one included). Each body is checked in its
+ * own fork of the semantic tree, whose file scope is not changed any more;
+ * the snapshot hides the structs completed after the definition.
+ * If several bodies contain errors, the first one in the source is reported.
+ */
+void Parser::analyzeDeferredFunctions() {
+  auto count = deferredFunctions.size();
+  std::vector<std::exception_ptr> errors(count);
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    CompilationContext::Activation activation(*context);
+    for (auto i = next++; i < count; i = next++) {
+      try {
+        auto & function = deferredFunctions[i];
+        SemanticTree::Snapshot snapshot(*function.scope);
+        function.definition->analyzeBody(*function.scope);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < semanticWorkers && i < count; ++i) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : workers) {
+    thread.join();
+  }
+  deferredFunctions.clear();
+  for (auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
 
 // canBeFunction is true at the beginning
@@ -233,7 +296,21 @@ TypeNode Parser::typeSpecifier() {
   if (testk("struct")) {
     return structOrUnionSpecifier();
   } else {
-    auto type = std::make_shared<BasicType>(m_nextsym->value(), pos);
+    auto name = m_nextsym->value();
+    if (name == "unsigned" || name == "long") {
+      // unsigned [long] [int] and long [int]; the BasicType gets the full name
+      auto isUnsigned = (name == "unsigned");
+      auto isLong = !isUnsigned;
+      if (isUnsigned && testLookAheadK("long")) {
+        scan();
+        isLong = true;
+      }
+      if (testLookAheadK("int")) {
+        scan();
+      }
+      name = std::string(isUnsigned ? "unsigned " : "") + (isLong ? "long" : "int");
+    }
+    auto type = std::make_shared<BasicType>(name, pos);
     scan();
     if (testp(PunctuatorType::SEMICOLON) && !type->containsDeclaration()) {
       throw ParsingException("Declaration doesn't declare anything!", pos);
@@ -355,7 +432,7 @@ SubExpression Parser::postfixExpression(SubExpression child) {
                                         : PunctuatorType::ARROW;
         scan();
         expect(TokenType::IDENTIFIER);
-        auto var = make_shared<VariableUsage>(m_nextsym->value(), pos, semanticTree);
+        auto var = make_shared<VariableUsage>(m_nextsym->value(), pos);
         child = make_shared<BinaryExpression>(child, var, p, pos);
         scan();
       } else {
@@ -379,7 +456,7 @@ SubExpression Parser::computeAtom() {
   } else if ( m_nextsym->type() == TokenType::IDENTIFIER ) {
     // 'normal ' atom, variable 
     // maybe followed by one of ., ->, [], ()
-    auto var = std::make_shared<VariableUsage>(m_nextsym->value(), pos, semanticTree);
+    auto var = std::make_shared<VariableUsage>(m_nextsym->value(), pos);
     scan();
     auto child = SubExpression(var);
     // handle postfix-expression
@@ -417,11 +494,7 @@ SubExpression Parser::computeAtom() {
     // TODO: get rid of ridiculous if expression
     if (    PunctuatorType::SIZEOF == op
          && testp(PunctuatorType::LEFTPARENTHESIS)
-         && m_lookahead->type() == TokenType::KEYWORD
-         && (   m_lookahead->value() == "char"
-             || m_lookahead->value() == "int"
-             || m_lookahead->value() == "void"
-             || m_lookahead->value() == "struct")) {
+         && testLookAheadType()) {
       return sizeOfType(); 
     } else {
       operand = expression(precNext);
@@ -475,7 +548,6 @@ SubExpression Parser::expression(int minPrecedence = 0) {
       expr = make_shared<BinaryExpression>(expr, rhs, punctype, pos, &operator_position);
     }
   }
-  expr->checkSemanticConstraints();
   return expr;
 }
 
@@ -491,7 +563,7 @@ DeclarationNode Parser::declaration() {
     auto decl = declarator();
     expect(PunctuatorType::SEMICOLON);
     scan();
-    return std::make_shared<Declaration>(type, decl, pos, semanticTree);
+    return std::make_shared<Declaration>(type, decl, pos);
   }
 }
 
@@ -513,40 +585,26 @@ StructNode Parser::structOrUnionSpecifier() {
 
     scan();
     if (testp(PunctuatorType::LEFTCURLYBRACE)) {
-      semanticTree->addChild(pos, "@"+name);
       expect(PunctuatorType::LEFTCURLYBRACE);
       scan();
       auto structDecLst = structDeclarationList();
       expect(PunctuatorType::RIGHTCURLYBRACE);
       scan();
-      auto ret =  make_shared<StructType>(name, structDecLst, pos);
-      semanticTree->goUp();
-      return ret;
-    } else if(!testp(PunctuatorType::SEMICOLON)) {
-      // check for struct S something;
-      string myname = "@"+ name;
-      if (!semanticTree->hasStructDeclaration(myname)) {
-        semanticTree->addChild(pos, myname, true);
-        semanticTree->goUp();
-      }
+      return make_shared<StructType>(name, structDecLst, pos);
     }
-    return make_shared<StructType>(name, pos);
+    // struct S something; declares S if it is not known yet
+    return make_shared<StructType>(name, pos, !testp(PunctuatorType::SEMICOLON));
   } else  if (testp(PunctuatorType::LEFTCURLYBRACE)) {
       structInPlace = structInPlace+"u";
       
-      string name = "@@" + structInPlace;
       string type = "@" + structInPlace;
 
-
-      semanticTree->addChild(pos, name);
       expect(PunctuatorType::LEFTCURLYBRACE);
       scan();
       auto structDecLst = structDeclarationList();
       expect(PunctuatorType::RIGHTCURLYBRACE);
       scan();
-      auto ret =  make_shared<StructType>(type, structDecLst, pos);
-      semanticTree->goUp();
-      return ret;
+      return make_shared<StructType>(type, structDecLst, pos);
     }
   else {
     expectedAnyOf();
@@ -611,10 +669,7 @@ std::pair<SubDeclarator,SubExpression> Parser::structDeclarator(TypeNode type) {
     return std::make_pair(SubDeclarator(), constantExpression());
   } else {
 
-    OBTAIN_POS();
     auto decl = declarator();
-    
-    semanticTree->addDeclaration(type, decl, pos);
 
     if (testp(":")) {
       scan();
@@ -727,15 +782,22 @@ std::pair<TypeNode, SubDeclarator>  Parser::typeName() {
 /*
 declarator ->   pointer direct-declarator
               | direct-declarator
+pointer -> "*" "restrict"* pointer?
 */
 SubDeclarator Parser::declarator(ThreeValueBool abstract) {
   OBTAIN_POS();
   int counter = 0;
+  // only the qualifier of the last * applies to the declared pointer itself
+  bool restrictQualified = false;
 
   if(test(TokenType::PUNCTUATOR,"*")) {
     while(testp(PunctuatorType::STAR)) {
       counter++;
       scan();
+      restrictQualified = testk(KeywordType::RESTRICT);
+      while (testk(KeywordType::RESTRICT)) {
+        scan();
+      }
     }
   }
 
@@ -747,12 +809,12 @@ SubDeclarator Parser::declarator(ThreeValueBool abstract) {
 
  return make_shared<Declarator>(counter,
         decltype(directDeclarator(abstract))(),
-        pos);
+        pos, restrictQualified);
 
 
   } else {
     SubDirectDeclarator dec = directDeclarator(abstract);
-    return make_shared<Declarator>(counter, dec, pos);
+    return make_shared<Declarator>(counter, dec, pos, restrictQualified);
  }
 }
 
@@ -877,42 +939,21 @@ void Parser::directDeclaratorHelp(std::vector<SubDirectDeclaratorHelp> & hs ,Thr
 compound-statement -> "{" block-item-list "}"
                      |  "{" "}"
 */
-SubCompoundStatement Parser::compoundStatement(vector<ParameterNode> paramList ) {
+SubCompoundStatement Parser::compoundStatement() {
   OBTAIN_POS();
 
-  // add a new child to the semantic tree
-  // and go to that child
-  semanticTree->addChild(pos);
-
-  // add variables for the function
-  if (!paramList.empty()) {
-    auto fu = static_pointer_cast<FunctionDeclaration>(semanticTree->currentFunction());
-    std::vector<Parsing::SemanticDeclarationNode> params;
-    for (auto par : paramList) {
-      auto pa = semanticTree->addDeclaration(par->getType(), par->getDeclarator(), pos);
-      if (pa) {
-        params.push_back(pa);
-      }
-    }
-    fu->rebindParameters(params);
-  }
-
   expect(PunctuatorType::LEFTCURLYBRACE);
   scan();
 
   decltype(blockItemList()) subStatements {}; 
   if (testp(PunctuatorType::RIGHTCURLYBRACE)) {
     scan();
-    auto statement = make_shared<CompoundStatement>(subStatements, pos);
-    semanticTree->goUp();
-    return statement;
+    return make_shared<CompoundStatement>(subStatements, pos);
   } else {
     subStatements = blockItemList();
     expect(PunctuatorType::RIGHTCURLYBRACE);
     scan();
-    auto statement = make_shared<CompoundStatement>(subStatements, pos);
-    semanticTree->goUp();
-    return statement;
+    return make_shared<CompoundStatement>(subStatements, pos);
   }
 }
 
@@ -959,9 +1000,12 @@ SubStatement Parser::statement() {
     return jumpStatement();
   } else if(testp(PunctuatorType::LEFTCURLYBRACE)) {
     return compoundStatement();
-  } else if(testk(KeywordType::IF)) {
+  } else if(testk(KeywordType::IF) || testk(KeywordType::SWITCH)) {
     return selectionStatement();
-  } else if(testk(KeywordType::WHILE) || testk(KeywordType::DO)) {
+  } else if(testk(KeywordType::CASE) || testk(KeywordType::DEFAULT)) {
+    return labeledStatement();
+  } else if(testk(KeywordType::WHILE) || testk(KeywordType::DO)
+            || testk(KeywordType::FOR)) {
     return iterationStatement();
   } else if(testType(TokenType::IDENTIFIER)) {
     if (testLookAheadP(":")) {
@@ -996,23 +1040,32 @@ SubExpressionStatement Parser::expressionStatement() {
 }
 
 /*
-labeled-statement -> identifier : statement
+labeled-statement ->   identifier ":" statement
+                     | "case" constant-expression ":" statement
+                     | "default" ":" statement
 */
-SubLabeledStatement Parser::labeledStatement() {
+SubStatement Parser::labeledStatement() {
   OBTAIN_POS();
-  if(testType(TokenType::IDENTIFIER)) {
+  if (testk(KeywordType::CASE)) {
+    scan();
+    SubExpression ex = constantExpression();
+    expect(PunctuatorType::COLON);
+    scan();
+    SubStatement st = statement();
+    return make_shared<CaseStatement>(ex, st, pos);
+  } else if (testk(KeywordType::DEFAULT)) {
+    scan();
+    expect(PunctuatorType::COLON);
+    scan();
+    SubStatement st = statement();
+    return make_shared<CaseStatement>(st, pos);
+  } else if(testType(TokenType::IDENTIFIER)) {
     std::string label = m_nextsym->value();
     scan();
     expect(PunctuatorType::COLON);
     scan();
 
     SubStatement st = statement();
-    bool unique = semanticTree->addLabel(label);
-
-    if(!unique) {
-      reportError(pos, "The label " + label + " is already defined");
-    }
-    
     return make_shared<LabeledStatement>(label, st, pos);
   } else {
     expectedAnyOf(std::string("labeled-statement : identifier expected"));
@@ -1022,14 +1075,13 @@ SubLabeledStatement Parser::labeledStatement() {
 /*
 iteration-statement ->  "while" "(" expression ")" statement
                       | "do" statement "while" "(" expression ")" ";"
+                      | "for" "(" expression? ";" expression? ";" expression? ")"
+                          statement
 
 */
 SubIterationStatement Parser::iterationStatement() {
   OBTAIN_POS();
 
-  // we can have break and continue here
-  semanticTree->increaseLoopDepth();
-
   if(testk(KeywordType::WHILE)) {
     scan();
     expect(PunctuatorType::LEFTPARENTHESIS);
@@ -1038,7 +1090,6 @@ SubIterationStatement Parser::iterationStatement() {
     expect(PunctuatorType::RIGHTPARENTHESIS);
     scan();
     SubStatement st = statement();
-    semanticTree->decreaseLoopDepth();
     return make_shared<IterationStatement>(ex, st, IterationEnum::WHILE, pos);
   } else if (testk(KeywordType::DO)) {
     scan();
@@ -1052,9 +1103,30 @@ SubIterationStatement Parser::iterationStatement() {
     scan();
     expect(PunctuatorType::SEMICOLON);
     scan();
-    semanticTree->decreaseLoopDepth();
     return make_shared<IterationStatement>(ex, st, IterationEnum::DOWHILE, pos);
 
+  } else if (testk(KeywordType::FOR)) {
+    scan();
+    expect(PunctuatorType::LEFTPARENTHESIS);
+    scan();
+    SubExpression init, ex, step;
+    if (!testp(PunctuatorType::SEMICOLON)) {
+      init = expression();
+    }
+    expect(PunctuatorType::SEMICOLON);
+    scan();
+    if (!testp(PunctuatorType::SEMICOLON)) {
+      ex = expression();
+    }
+    expect(PunctuatorType::SEMICOLON);
+    scan();
+    if (!testp(PunctuatorType::RIGHTPARENTHESIS)) {
+      step = expression();
+    }
+    expect(PunctuatorType::RIGHTPARENTHESIS);
+    scan();
+    SubStatement st = statement();
+    return make_shared<IterationStatement>(init, ex, step, st, pos);
   } else {
     expectedAnyOf(std::string("iteration-statement : no match found"));
   }
@@ -1064,9 +1136,10 @@ SubIterationStatement Parser::iterationStatement() {
 /*
 selection-statement ->   "if" "(" expression ")" statement
    | "if" "(" expression ")" statement "else" statement
+   | "switch" "(" expression ")" statement
 */
 
-SubSelectionStatement Parser::selectionStatement() {
+SubStatement Parser::selectionStatement() {
   OBTAIN_POS();
   if (testk(KeywordType::IF)) {
     scan();
@@ -1085,6 +1158,16 @@ SubSelectionStatement Parser::selectionStatement() {
     } else {
       return make_shared<SelectionStatement>(ex, st1, pos);
     }
+  } else if (testk(KeywordType::SWITCH)) {
+    scan();
+
+    expect(PunctuatorType::LEFTPARENTHESIS);
+    scan();
+    SubExpression ex = expression();
+    expect(PunctuatorType::RIGHTPARENTHESIS);
+    scan();
+    SubStatement st = statement();
+    return make_shared<SwitchStatement>(ex, st, pos);
   } else {
     expectedAnyOf(std::string("selectionStatement: no match"));
   }
@@ -1103,9 +1186,6 @@ SubJumpStatement Parser::jumpStatement() {
   if (testk(KeywordType::GOTO)) {
     scan();
     if(testType(TokenType::IDENTIFIER)) {
-
-      semanticTree->addGotoLabel(m_nextsym->value(), pos);
-
       SubJumpStatement gotoStatement = make_shared<GotoStatement>(m_nextsym->value(), pos);
       scan();
 
@@ -1117,19 +1197,12 @@ SubJumpStatement Parser::jumpStatement() {
       expectedAnyOf(std::string("jump-statement: identifier expected"));
     }
   } else if (testk(KeywordType::CONTINUE)) {
-    if (!semanticTree->isInLoop()) {
-      reportError("continue must be inside a loop");
-    }
-
     scan();
     expect(PunctuatorType::SEMICOLON);
     scan();
 
     return make_shared<ContinueStatement>(pos);
   } else if (testk(KeywordType::BREAK)) {
-    if (!semanticTree->isInLoop()) {
-      reportError("break must be inside a loop");
-    }
     scan();
     expect(PunctuatorType::SEMICOLON);
     scan();
@@ -29,14 +29,32 @@ namespace Parsing {
   class Parser
   {
     public:
-      Parser(FILE* f, char const *name);
+      /*
+       * By default, each function body is checked as soon as it is parsed.
+       * With semanticWorkers > 0, the bodies are checked after the whole
+       * translation unit has been parsed, by that many threads at once.
+       */
+      Parser(FILE* f, char const *name, unsigned semanticWorkers = 0);
       AstRoot parse();
+      // the context of the parsed translation unit; it has to be activated
+      // when working with the AST
+      std::shared_ptr<CompilationContext> compilationContext();
 
     private:
       std::unique_ptr<Lexing::Lexer> m_lexer;
       std::shared_ptr<Lexing::Token> m_nextsym;
       std::shared_ptr<Lexing::Token> m_lookahead;
+      std::shared_ptr<CompilationContext> context;
       std::shared_ptr<SemanticTree> semanticTree;
+      unsigned semanticWorkers;
+
+      // a function definition whose body has not been checked yet
+      struct DeferredFunction {
+        std::shared_ptr<FunctionDefinition> definition;
+        std::shared_ptr<SemanticTree> scope;
+      };
+      std::vector<DeferredFunction> deferredFunctions;
+      void analyzeDeferredFunctions();
 
       // function concerning reading
       std::shared_ptr<Lexing::Token> getNextSymbol();
@@ -52,6 +70,7 @@ namespace Parsing {
       bool testk(KeywordType keyword); // test keyword
       bool testTypeSpecifier();
       bool testLookAheadP(std::string val);
+      bool testLookAheadK(std::string val);
       bool testLookAheadType();
       void expected(std::string expected);
       void expect(PunctuatorType puncutator);
@@ -70,9 +89,9 @@ namespace Parsing {
       // statements
       SubStatement statement();
       SubJumpStatement jumpStatement();
-      SubSelectionStatement selectionStatement();
+      SubStatement selectionStatement();
       SubIterationStatement iterationStatement();
-      SubLabeledStatement labeledStatement();
+      SubStatement labeledStatement();
 
       SubExpression expression(int minPrecedence);
       SubExpression computeAtom();
@@ -101,7 +120,7 @@ namespace Parsing {
       ExternalDeclarationNode externalDeclaration();
       TUNode translationUnit();
 
-      SubCompoundStatement compoundStatement(std::vector<ParameterNode> param = std::vector<ParameterNode>() );
+      SubCompoundStatement compoundStatement();
       SubExpressionStatement expressionStatement();
   };
 }
@@ -192,6 +192,15 @@ PRETTY_PRINT(BasicType)
     case CHAR:
       PPRINT(std::string("char"));
       break;
+    case LONG:
+      PPRINT(std::string("long"));
+      break;
+    case UNSIGNED:
+      PPRINT(std::string("unsigned int"));
+      break;
+    case UNSIGNED_LONG:
+      PPRINT(std::string("unsigned long"));
+      break;
     default :
       /*case VOID: */
       PPRINT(std::string("void"));
@@ -347,9 +356,24 @@ PRETTY_PRINT(ReturnStatement) {
 
 PRETTY_PRINT(IterationStatement) {
   PPRINT('\n');
-  if (kind == WHILE) {
-    PPRINT(std::string("while ("));
-    PPRINT(expression);
+  if (kind == WHILE || kind == FOR) {
+    if (kind == WHILE) {
+      PPRINT(std::string("while ("));
+      PPRINT(expression);
+    } else {
+      PPRINT(std::string("for ("));
+      if (init) {
+        PPRINT(init);
+      }
+      PPRINT(std::string("; "));
+      if (expression) {
+        PPRINT(expression);
+      }
+      PPRINT(std::string("; "));
+      if (step) {
+        PPRINT(step);
+      }
+    }
     PPRINT(std::string(")"));
     if (std::dynamic_pointer_cast<CompoundStatement>(statement)) {
       g_skipNewLineBeforeBlockStatement = true;
@@ -381,6 +405,33 @@ PRETTY_PRINT(LabeledStatement) {
   }
 }
 
+PRETTY_PRINT(SwitchStatement) {
+  PPRINT('\n');
+  PPRINT(std::string("switch ("));
+  PPRINT(expression);
+  PPRINT(std::string(")"));
+  if (std::dynamic_pointer_cast<CompoundStatement>(statement)) {
+    g_skipNewLineBeforeBlockStatement = true;
+    PPRINT(statement);
+  } else {
+    ADDINDENT();
+    PPRINT(statement);
+    REMOVEINDENT();
+  }
+}
+
+PRETTY_PRINT(CaseStatement) {
+  PPRINT('\n');
+  if (expression) {
+    PPRINT(std::string("case "));
+    PPRINT(expression);
+    PPRINT(std::string(":"));
+  } else {
+    PPRINT(std::string("default:"));
+  }
+  PPRINT(statement);
+}
+
 PRETTY_PRINT(IdentifierList) {
   PPRINT(nameList[0]);
   for(int n = 1; n < (int) nameList.size(); n++) {
@@ -395,6 +446,9 @@ PRETTY_PRINT(Declarator)
   for (auto i = this->pointerCounter; i>0; --i) {
     PPRINT('(');
     PPRINT('*');
+    if (i == 1 && this->restrictQualified) {
+      PPRINT("restrict ");
+    }
   }
   if (directDeclarator) {
     PPRINT(this->directDeclarator);
@@ -428,6 +482,9 @@ PRETTY_PRINT(TranslationUnit) {
 
 PRETTY_PRINT(ExternalDeclaration) {
   /*TODO: unfinished */
+  if (this->isStatic) {
+    PPRINT("static ");
+  }
   PPRINT(this->type);
   if (this->declarator) {
     PPRINT(' ');
@@ -441,6 +498,9 @@ PRETTY_PRINT(ExternalDeclaration) {
 
 PRETTY_PRINT(FunctionDefinition) {
   /*TODO: unfinished */
+  if (this->isStatic) {
+    PPRINT("static ");
+  }
   PPRINT(this->type);
   PPRINT(' ');
   PPRINT(this->declarator);
@@ -1,6 +1,7 @@
 #include "semadecl.h"
 #include "semantic.h"
 #include <string>
+#include <functional>
 
 using namespace Parsing;
 
@@ -37,6 +38,39 @@ std::string NullDeclaration::toString() {
 }
 
 
+Semantic::Type LongDeclaration::type()
+{
+  return Semantic::Type::LONG;
+}
+
+std::string LongDeclaration::toString()
+{
+  return "long";
+}
+
+
+Semantic::Type UnsignedDeclaration::type()
+{
+  return Semantic::Type::UNSIGNED;
+}
+
+std::string UnsignedDeclaration::toString()
+{
+  return "unsigned int";
+}
+
+
+Semantic::Type UnsignedLongDeclaration::type()
+{
+  return Semantic::Type::UNSIGNED_LONG;
+}
+
+std::string UnsignedLongDeclaration::toString()
+{
+  return "unsigned long";
+}
+
+
 Semantic::Type CharDeclaration::type() 
 {
   return Semantic::Type::CHAR;
@@ -60,9 +94,9 @@ std::string VoidDeclaration::toString()
 }
 
 
-StructDeclaration::StructDeclaration(std::string n, SubSemanticNode s, bool selfReferencing) : llvm_type(nullptr), selfReferencing(selfReferencing), name(n), m_node(s) {}
+StructDeclaration::StructDeclaration(std::string n, SubSemanticNode s, bool selfReferencing) : llvm_type(nullptr), layout(nullptr), selfReferencing(selfReferencing), name(n), m_node(s) {}
 
-std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> StructDeclaration::members()
+const std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> & StructDeclaration::members()
 {
   return this->m_node->type();
 }
@@ -128,7 +162,7 @@ Parsing::SemanticDeclarationNode FunctionDeclaration::returnType()
 FunctionDeclaration::FunctionDeclaration(SemanticDeclarationNode ret, std::vector<SemanticDeclarationNode> par) :returnChild(ret), m_parameter(par) 
 {
   if (m_parameter.size() == 1) {
-    if (std::dynamic_pointer_cast<VoidDeclaration>(m_parameter.front())) {
+    if (m_parameter.front()->type() == Semantic::Type::VOID) {
       /* 6.7.6.3:
        * The special case of an unnamed parameter of type void as the only item in the list
        * specifies that the function has no parameters.
@@ -146,6 +180,8 @@ FunctionDeclaration::FunctionDeclaration(SemanticDeclarationNode ret, std::vecto
 void FunctionDeclaration::rebindParameters(std::vector<Parsing::SemanticDeclarationNode> parameters)
 {
   if (!(parameters.size() == 1 && parameters[0]->type() == Semantic::Type::VOID)) {
+    // the parameters might differ from the ones we were interned with
+    canonical = nullptr;
     m_parameter.clear();
     for (auto p: parameters) {
       m_parameter.push_back(p);
@@ -199,49 +235,159 @@ std::string ArrayDeclaration::toString()
 
 using namespace Semantic;
 
-bool Semantic::compareTypes(SemanticDeclarationNode s1, SemanticDeclarationNode s2) {
-  if (s1->type() != s2->type()) {
-    return false;
+TypeContext::TypeContext() :
+  m_int(std::make_shared<IntDeclaration>()),
+  m_char(std::make_shared<CharDeclaration>()),
+  m_long(std::make_shared<LongDeclaration>()),
+  m_unsigned(std::make_shared<UnsignedDeclaration>()),
+  m_unsignedLong(std::make_shared<UnsignedLongDeclaration>()),
+  m_void(std::make_shared<VoidDeclaration>()),
+  m_null(std::make_shared<NullDeclaration>())
+{
+  m_int->canonical = m_int.get();
+  m_char->canonical = m_char.get();
+  m_long->canonical = m_long.get();
+  m_unsigned->canonical = m_unsigned.get();
+  m_unsignedLong->canonical = m_unsignedLong.get();
+  m_void->canonical = m_void.get();
+  // the null pointer constant compares equal to int
+  m_null->canonical = m_int.get();
+}
+
+SemanticDeclarationNode TypeContext::intType()
+{
+  return m_int;
+}
+
+SemanticDeclarationNode TypeContext::charType()
+{
+  return m_char;
+}
+
+SemanticDeclarationNode TypeContext::longType()
+{
+  return m_long;
+}
+
+SemanticDeclarationNode TypeContext::unsignedType()
+{
+  return m_unsigned;
+}
+
+SemanticDeclarationNode TypeContext::unsignedLongType()
+{
+  return m_unsignedLong;
+}
+
+SemanticDeclarationNode TypeContext::voidType()
+{
+  return m_void;
+}
+
+SemanticDeclarationNode TypeContext::nullType()
+{
+  return m_null;
+}
+
+bool TypeContext::Key::operator==(const Key & other) const
+{
+  return kind == other.kind
+    && child == other.child
+    && uid == other.uid
+    && name == other.name
+    && parameter == other.parameter;
+}
+
+size_t TypeContext::KeyHash::operator()(const Key & key) const
+{
+  size_t h = std::hash<int>()(static_cast<int>(key.kind));
+  auto combine = [&h](size_t v) {
+    h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+  };
+  combine(std::hash<SemanticDeclaration*>()(key.child));
+  combine(std::hash<size_t>()(key.uid));
+  combine(std::hash<std::string>()(key.name));
+  for (auto p: key.parameter) {
+    combine(std::hash<SemanticDeclaration*>()(p));
+  }
+  return h;
+}
+
+/*
+ * Returns the canonical node for key; if there is none yet, s becomes the
+ * representative of its type
+ */
+SemanticDeclaration* TypeContext::intern(Key key, const SemanticDeclarationNode & s)
+{
+  auto it = interned.find(key);
+  if (it == interned.end()) {
+    it = interned.insert(std::make_pair(std::move(key), s)).first;
+  }
+  return it->second.get();
+}
+
+SemanticDeclaration* TypeContext::canonical(const SemanticDeclarationNode & s)
+{
+  if (auto known = s->canonical.load()) {
+    return known;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  return canonicalLocked(s);
+}
+
+SemanticDeclaration* TypeContext::canonicalLocked(const SemanticDeclarationNode & s)
+{
+  if (auto known = s->canonical.load()) {
+    return known;
   }
-  switch (s1->type()) {
+  Key key {s->type(), nullptr, 0, "", {}};
+  switch (key.kind) {
     case Type::INT:
+      s->canonical = m_int.get();
+      break;
     case Type::CHAR:
+      s->canonical = m_char.get();
+      break;
+    case Type::LONG:
+      s->canonical = m_long.get();
+      break;
+    case Type::UNSIGNED:
+      s->canonical = m_unsigned.get();
+      break;
+    case Type::UNSIGNED_LONG:
+      s->canonical = m_unsignedLong.get();
+      break;
     case Type::VOID:
-      return true;
+      s->canonical = m_void.get();
+      break;
+    case Type::POINTER:
+      key.child = canonicalLocked(std::static_pointer_cast<PointerDeclaration>(s)->pointee());
+      s->canonical = intern(std::move(key), s);
       break;
     case Type::FUNCTION: {
-      auto ftype1 = std::static_pointer_cast<FunctionDeclaration>(s1);
-      auto ftype2 = std::static_pointer_cast<FunctionDeclaration>(s2);
-      auto same_return = compareTypes(ftype1->returnType(), ftype2->returnType());
-      if (!same_return) {return false;}
-      auto params1 = ftype1->parameter();
-      auto params2 = ftype2->parameter();
-      if (params1.size() != params2.size()) {return false;}
-      // TODO: write zip function to avoid explicit  for loop
-      for (signed int i = params1.size()-1; i >= 0; --i) { // without signed int >= 0 is always true
-        if (!compareTypes(params1.at(i), params2.at(i))) {
-          return false;
-        }
+      auto ftype = std::static_pointer_cast<FunctionDeclaration>(s);
+      key.child = canonicalLocked(ftype->returnType());
+      for (auto p: ftype->parameter()) {
+        key.parameter.push_back(canonicalLocked(p));
       }
-      return true;
+      s->canonical = intern(std::move(key), s);
+      break;
                          }
-    case Type::POINTER: {
-      auto ptype1 = std::static_pointer_cast<PointerDeclaration>(s1);
-      auto ptype2 = std::static_pointer_cast<PointerDeclaration>(s2);
-      return compareTypes(ptype1->pointee(), ptype2->pointee());
-                        }
     case Type::STRUCT: {
-      auto struct1 = std::static_pointer_cast<StructDeclaration>(s1);
-      auto struct2 = std::static_pointer_cast<StructDeclaration>(s2);
-      if (struct1->uid != struct2->uid) {
-        return false;
-      }
-      if (struct1->toString() != struct2->toString()) {
-        return false;
-      }
-      return true;
+      auto stype = std::static_pointer_cast<StructDeclaration>(s);
+      key.uid = stype->uid;
+      key.name = stype->toString();
+      s->canonical = intern(std::move(key), s);
+      break;
                        }
     default:
-      return false;
+      // not a type we can compare with anything else
+      return s.get();
   }
+  return s->canonical;
+}
+
+bool Semantic::compareTypes(SemanticDeclarationNode s1, SemanticDeclarationNode s2) {
+  auto & context = types();
+  return context.canonical(s1) == context.canonical(s2);
 }
@@ -4,6 +4,10 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace llvm {
   class Value;
@@ -14,6 +18,9 @@ namespace Semantic {
   enum class Type {
     INT,
     CHAR,
+    LONG,
+    UNSIGNED,        // unsigned int
+    UNSIGNED_LONG,
     VOID,
     POINTER,
     ARRAY,
@@ -33,6 +40,20 @@ namespace Parsing {
       virtual Semantic::Type type();
       bool isVoid();
       llvm::Value* associatedValue = nullptr;
+      // set by the semantic analysis when & is applied to the declared
+      // object; only objects whose address is never taken can live in
+      // registers
+      std::atomic<bool> addressTaken {false};
+      // representative of all types structurally equal to this one, computed
+      // lazily by Semantic::TypeContext
+      std::atomic<SemanticDeclaration*> canonical {nullptr};
+      // set by the semantic analysis when an expression refers to the
+      // declared object or function
+      std::atomic<bool> used {false};
+      // set for functions and file scope variables declared static
+      bool internalLinkage = false;
+      // set by the first file scope declaration, which decides the linkage
+      bool linkageDecided = false;
   };
 
   typedef std::shared_ptr<SemanticDeclaration> SemanticDeclarationNode;
@@ -48,6 +69,25 @@ namespace Parsing {
       std::string toString() override; 
   };
 
+  // long is 64 bits wide, like pointers on the hosts we target
+  class LongDeclaration : public SemanticDeclaration {
+    public:
+      Semantic::Type type() override;
+      std::string toString() override;
+  };
+
+  class UnsignedDeclaration : public SemanticDeclaration {
+    public:
+      Semantic::Type type() override;
+      std::string toString() override;
+  };
+
+  class UnsignedLongDeclaration : public SemanticDeclaration {
+    public:
+      Semantic::Type type() override;
+      std::string toString() override;
+  };
+
   class CharDeclaration : public SemanticDeclaration {
     public :
       Semantic::Type type() override;
@@ -66,6 +106,8 @@ namespace Parsing {
       Semantic::Type type() override;
       Parsing::SemanticDeclarationNode pointee();
       std::string toString() override;
+      // a qualifier, so it does not take part in comparisons of types
+      bool restrictQualified = false;
 
     private:
       Parsing::SemanticDeclarationNode child;
@@ -107,6 +149,18 @@ namespace Parsing {
 
   };
 
+  /* Layout of a struct definition, shared by every StructDeclaration that
+   * refers to it. Member names are mapped to their index by the struct's
+   * SemanticNode; the code generator fills in the LLVM type and the byte
+   * offset of each field the first time it lowers the struct */
+  struct StructLayout {
+    struct Field {
+      llvm::Type* llvm_type;
+      uint64_t offset;
+    };
+    std::vector<Field> fields;
+  };
+
   class StructDeclaration : public SemanticDeclaration {
 
     public:  
@@ -116,12 +170,14 @@ namespace Parsing {
       std::string toString() override;
       bool isSelfReferencing();
       /* return members as a vector of name type pairs */
-      std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>>
+      const std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> &
         members();
       SubSemanticNode node();
       // required to handle self-referencing structs in cogen
       std::shared_ptr<llvm::Type*> llvm_type;
+      std::shared_ptr<StructLayout> layout;
       bool selfReferencing;
+      // identifies the struct definition inside its translation unit
       size_t uid = 0;
     private:
       std::string name;
@@ -131,6 +187,63 @@ namespace Parsing {
 }
 
 namespace Semantic {
+  /*
+   * Interns semantic types: all structurally equal types share one canonical
+   * node, so that comparing two types is a pointer comparison. Arrays are
+   * interned like pointers and the null pointer constant like int, as
+   * compareTypes has always treated them that way.
+   *
+   * Declarations keep a node of their own, as it carries the associatedValue
+   * of the declared object; expressions use the shared basic types below
+   * instead of allocating new ones.
+   *
+   * Function bodies may be checked on several threads at once, so interning
+   * is serialised; types which already know their canonical node are
+   * compared without taking the lock.
+   */
+  class TypeContext {
+    public:
+      Parsing::SemanticDeclarationNode intType();
+      Parsing::SemanticDeclarationNode charType();
+      Parsing::SemanticDeclarationNode longType();
+      Parsing::SemanticDeclarationNode unsignedType();
+      // also the type of sizeof, i.e. size_t
+      Parsing::SemanticDeclarationNode unsignedLongType();
+      Parsing::SemanticDeclarationNode voidType();
+      Parsing::SemanticDeclarationNode nullType();
+      Parsing::SemanticDeclaration* canonical(const Parsing::SemanticDeclarationNode & s);
+      TypeContext();
+
+    private:
+      struct Key {
+        Type kind;
+        Parsing::SemanticDeclaration* child;
+        size_t uid;
+        std::string name;
+        std::vector<Parsing::SemanticDeclaration*> parameter;
+        bool operator==(const Key & other) const;
+      };
+      struct KeyHash {
+        size_t operator()(const Key & key) const;
+      };
+      Parsing::SemanticDeclaration* intern(Key key, const Parsing::SemanticDeclarationNode & s);
+      // canonical(), but the caller holds mutex
+      Parsing::SemanticDeclaration* canonicalLocked(const Parsing::SemanticDeclarationNode & s);
+
+      Parsing::SemanticDeclarationNode m_int;
+      Parsing::SemanticDeclarationNode m_char;
+      Parsing::SemanticDeclarationNode m_long;
+      Parsing::SemanticDeclarationNode m_unsigned;
+      Parsing::SemanticDeclarationNode m_unsignedLong;
+      Parsing::SemanticDeclarationNode m_void;
+      Parsing::SemanticDeclarationNode m_null;
+      std::unordered_map<Key, Parsing::SemanticDeclarationNode, KeyHash> interned;
+      std::mutex mutex;
+  };
+
+  // the type context of the active Parsing::CompilationContext
+  TypeContext & types();
+
   // TODO: should this be implemented in terms of operator == ?
   bool compareTypes(Parsing::SemanticDeclarationNode s1, Parsing::SemanticDeclarationNode s2);
 }
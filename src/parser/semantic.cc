@@ -5,6 +5,7 @@
 #include "../utils/datastructures.h"
 
 # include <algorithm>
+# include <limits>
 
 using namespace std;
 using namespace Parsing;
@@ -42,27 +43,29 @@ bool isValidType(const SemanticDeclarationNode & s) {
 
 /*===========Semantic Node=============*/
 
-SemanticNode::SemanticNode(int parent, bool insideStruct, bool forward) :
-  parent(parent), active(true), insideStruct(insideStruct), forward(forward) {}
+namespace {
+  // the completed structs a snapshot on this thread sees, see Snapshot
+  thread_local size_t snapshotCompletions = std::numeric_limits<size_t>::max();
+}
+
+SemanticNode::SemanticNode(bool insideStruct, bool forward) :
+  active(true), insideStruct(insideStruct), forward(forward), completion(0) {}
 
 void SemanticNode::disable() {
   active = false;
 }
 
-int SemanticNode::getParentIndex() {
-  return parent;
-}
-
 bool SemanticNode::isActive() {
   return active;
 }
 
 bool SemanticNode::isForward() {
-  return forward;
+  return forward || completion > snapshotCompletions;
 }
 
-void SemanticNode::setNotForward() {
+void SemanticNode::setNotForward(size_t completion) {
   forward = false;
+  this->completion = completion;
 }
 
 void SemanticNode::addDeclaration(
@@ -72,131 +75,149 @@ void SemanticNode::addDeclaration(
 }
 
 
-std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> SemanticNode::type() {
-  return std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>>(
-      decl.begin(), decl.end()
-      );
+const std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> & SemanticNode::type() {
+  return decl.as_list();
 }
 
 bool SemanticNode::isInsideStruct() {
   return insideStruct;
 }
 
+void SemanticNode::clear() {
+  decl = decltype(decl) {};
+}
+
 Parsing::SemanticDeclarationNode SemanticNode::getNode(std::string name) {
-  if (decl.find(name) == decl.end()) {
+  unsigned index;
+  return getNode(name, index);
+}
+
+Parsing::SemanticDeclarationNode SemanticNode::getNode(std::string name, unsigned &index) {
+  auto member = decl.find(name);
+  // an incomplete struct has no members yet
+  if (member == decl.end() || isForward()) {
     throw SemanticException(name + " not found");
   } else {
-    return decl[name];
+    index = member - decl.begin();
+    return member->second;
   }
 }
 
 /*====SemanticTree======*/
 
 bool SemanticTree::hasStructDeclaration(std::string name) {
-  if (structMap.find(name) == structMap.end()) {
-    return false;
-  } else {
-      // check whether it is empty
-
-      // delete not active nodes
-      while(!structMap[name].empty()) {
-        int id = structMap[name].top().first;
-        int parent = nodes[id]->getParentIndex();
-        if (nodes[parent]->isActive()) {
-          break;
-        }else {
-          structMap[name].pop();
-        }
-      }
-
-      return !structMap[name].empty();
-  }
+  return findStruct(name) != nullptr;
 }
 
 
 SemanticTree::SemanticTree() {
-  counter = 0;
   loopDepth = 0;
-  currentPos = 0;
-  nodes.push_back(make_shared<SemanticNode>(-1, false));
-  counter++;
+  completedStructs = 0;
+  visibleDeclarations = 0;
+  visibleStructs = 0;
+  visibleCompletions = 0;
+  scopes.push_back(make_shared<SemanticNode>(false));
+}
+
+shared_ptr<SemanticTree> SemanticTree::fork() {
+  auto & fileTree = root();
+  shared_ptr<SemanticTree> forked(new SemanticTree());
+  forked->fileScope = &fileTree;
+  forked->visibleDeclarations = fileTree.declarations.size();
+  forked->visibleStructs = fileTree.structs.size();
+  forked->visibleCompletions = fileTree.completedStructs;
+  return forked;
+}
+
+SemanticTree::Snapshot::Snapshot(const SemanticTree & fork)
+  : previous(snapshotCompletions)
+{
+  snapshotCompletions = fork.visibleCompletions;
+}
+
+SemanticTree::Snapshot::~Snapshot()
+{
+  snapshotCompletions = previous;
+}
+
+SemanticTree & SemanticTree::root() {
+  return fileScope ? *fileScope : *this;
+}
+
+util::ScopedSymbolTable<SubSemanticNode>::Binding* SemanticTree::findStruct(string name) {
+  auto binding = structs.find(name);
+  if (!binding && fileScope) {
+    binding = fileScope->structs.find(name, visibleStructs);
+  }
+  return binding;
+}
+
+pair<SemanticDeclarationNode, bool>* SemanticTree::findFunction(string name) {
+  auto function = functionMap.find(name);
+  if (function != functionMap.end()) {
+    return &function->second;
+  }
+  return fileScope ? fileScope->findFunction(name) : nullptr;
+}
+
+bool SemanticTree::isDefinedFunction(string name) {
+  auto function = findFunction(name);
+  return function && !function->second;
 }
 
 SemanticTree::~SemanticTree() {
-  for (auto const & it : declarationMap) {
-    delete it.second;
+  for (auto & entry: structRegistry) {
+    entry.second.node->clear();
   }
-  declarationMap.clear();
 }
 
 void SemanticTree::addChild(Pos pos, string name, bool forward) {
 
    debug(SEMANTIC) << name<<" "<<forward;
 
-  bool insideStruct = nodes[currentPos]->isInsideStruct();
+  bool insideStruct = scopes.back()->isInsideStruct();
   // save the struct definitions
   if (name != "@@") {
     insideStruct = true;
 
-    if(structMap.find(name) == structMap.end()) {
-      stack<pair<int,bool> > st = stack<pair<int, bool> >();
-      st.push(
-      make_pair(counter, forward)
-      );
-      structMap[name] = st;
-    } else {
-      SubSemanticNode helpNode;
-
-      // delete not active nodes
-      while(!structMap[name].empty()) {
-        int id = structMap[name].top().first;
-        int parent = nodes[id]->getParentIndex();
-        if (nodes[parent]->isActive()) {
-          helpNode = nodes[id];
-          break;
-        } else {
-          structMap[name].pop();
+    auto previous = findStruct(name);
+    // it was already declared in the current scope
+    if (previous && previous->depth == structs.depth()) {
+      auto helpNode = previous->value;
+      // it is a forward declaration
+      if (helpNode->isForward()) {
+        if (!forward) {
+          // it is not a forward declaration anymore; forks of the file
+          // scope made before this point still see it as one
+          helpNode->setNotForward(fileScope ? 0 : ++completedStructs);
         }
-      }
-
-      // add it to the Map
-      if (structMap[name].empty() || nodes[structMap[name].top().first]->getParentIndex() != currentPos) {
-
-          structMap[name].push(
-            make_pair(counter, forward) 
-          );
-      } else { // it was alredy declared
-          // it is a forward declaration
-             bool lastForward = structMap[name].top().second;
-
-             // take the node from the forward declaration
-             if (lastForward) {
-
-              if (!forward) {
-                // it is not a forward declaration anymore
-                auto helpPos = structMap[name].top().first;
-                // std::cout<<"go to pos : "<<helpPos<<endl;
-                nodes[helpPos]->setNotForward();
-              }
-
-              currentPos = structMap[name].top().first;
-              return;
-             } else {
-               // it is a redefinition
-                throw Parsing::ParsingException("no redefinition of " + name, pos);
-             }
+        // take the node from the forward declaration
+        scopes.push_back(helpNode);
+        declarations.pushScope();
+        structs.pushScope();
+        return;
+      } else {
+        // it is a redefinition
+        throw Parsing::ParsingException("no redefinition of " + name, pos);
       }
     }
+
+    auto node = make_shared<SemanticNode>(insideStruct, forward);
+    structs.bind(name, node);
+    scopes.push_back(node);
+  } else {
+    scopes.push_back(make_shared<SemanticNode>(insideStruct, forward));
   }
-  nodes.push_back(make_shared<SemanticNode>(currentPos, insideStruct, forward));
-  counter++;
-  currentPos = counter - 1;
-  }
+  declarations.pushScope();
+  structs.pushScope();
+}
 
 void SemanticTree::goUp() {
   //debug(SEMANTIC)<<"go up";
-  nodes[currentPos]->disable();
-  currentPos = nodes[currentPos]->getParentIndex();
+  scopes.back()->disable();
+  scopes.pop_back();
+  declarations.popScope();
+  structs.popScope();
 }
 
 void SemanticTree::addGotoLabel(string str, Pos pos) {
@@ -211,14 +232,6 @@ void SemanticTree::checkGotoLabels() {
   }
 }
 
-void SemanticTree::deleteNotActiveNodes(TypeStack *st) {
-  while (st->size() > 0 && 
-      !nodes[st->top().first]->isActive()
-      ) {
-    st->pop();
-  }
-}
-
 bool SemanticTree::isInLoop() {
   return loopDepth > 0;
 }
@@ -231,6 +244,38 @@ void SemanticTree::decreaseLoopDepth() {
   loopDepth--;
 }
 
+bool SemanticTree::isBreakable() {
+  return isInLoop() || !switches.empty();
+}
+
+void SemanticTree::enterSwitch() {
+  switches.push_back(SwitchLabels {std::set<int>(), false});
+}
+
+void SemanticTree::leaveSwitch() {
+  switches.pop_back();
+}
+
+void SemanticTree::addCaseLabel(int value, Pos pos) {
+  if (switches.empty()) {
+    throw Parsing::ParsingException("case must be inside a switch", pos);
+  }
+  if (!switches.back().cases.insert(value).second) {
+    throw Parsing::ParsingException("duplicate case value "
+                                    + std::to_string(value), pos);
+  }
+}
+
+void SemanticTree::addDefaultLabel(Pos pos) {
+  if (switches.empty()) {
+    throw Parsing::ParsingException("default must be inside a switch", pos);
+  }
+  if (switches.back().hasDefault) {
+    throw Parsing::ParsingException("multiple default labels in one switch", pos);
+  }
+  switches.back().hasDefault = true;
+}
+
 
 Parsing::SemanticDeclarationNode SemanticTree::currentFunction() {
   return m_currentFunction;
@@ -264,7 +309,6 @@ bool hasSameType(SemanticDeclarationNode a, SemanticDeclarationNode b) {
 }
 
 SemanticDeclarationNode SemanticTree::createType(TypeNode typeNode, Pos pos) {
-  static std::map<std::string, std::shared_ptr<llvm::Type*>> structname2structtype {};
    SemanticDeclarationNode myDeclaration;
 
     string type = typeNode->toString();
@@ -272,6 +316,12 @@ SemanticDeclarationNode SemanticTree::createType(TypeNode typeNode, Pos pos) {
        myDeclaration = make_shared<IntDeclaration>();
      } else if (type == "char") {
        myDeclaration = make_shared<CharDeclaration>();
+     } else if (type == "long") {
+       myDeclaration = make_shared<LongDeclaration>();
+     } else if (type == "unsigned int") {
+       myDeclaration = make_shared<UnsignedDeclaration>();
+     } else if (type == "unsigned long") {
+       myDeclaration = make_shared<UnsignedLongDeclaration>();
      } else if (type == "void") {
        // TODO This might be an error, but does not need to be
        // depends on the contex
@@ -280,37 +330,30 @@ SemanticDeclarationNode SemanticTree::createType(TypeNode typeNode, Pos pos) {
        // TODO structs
        string name = "@" + type;
         
-       SubSemanticNode helpNode;
-       auto id = int{};
-       while(!structMap[name].empty()) {
-        id = structMap[name].top().first;
-        int parent = nodes[id]->getParentIndex();
-        if (nodes[parent]->isActive()) {
-          helpNode = nodes[id];
-          break;
-        } else {
-          structMap[name].pop();
-        }
-       }
+       auto binding = findStruct(name);
+       SubSemanticNode helpNode = binding ? binding->value : SubSemanticNode {};
 
        if (helpNode) {
-         auto ptr = (size_t) helpNode.operator->(); // TODO FIXME WARNING HACK !!!!!
-         auto name = "@" + type;
-         if (structname2structtype.find(name) == structname2structtype.end()) {
+         auto & registry = root();
+         std::unique_lock<std::mutex> lock(registry.structRegistryMutex);
+         auto entry = registry.structRegistry.find(helpNode.get());
+         if (entry == registry.structRegistry.end()) {
            debug(SEMANTIC) << "New";
-           auto as_struct = make_shared<StructDeclaration>(name, helpNode, nodes[id]->isActive());
-           structname2structtype[name] = std::make_shared<llvm::Type*>(nullptr);
-           as_struct->llvm_type = structname2structtype[name];
-           as_struct->uid = ptr;
-           myDeclaration = as_struct;
-         } else {
-           debug(SEMANTIC) << "Old";
-           auto as_struct = make_shared<StructDeclaration>(name, helpNode, nodes[id]->isActive());
-           as_struct->llvm_type = structname2structtype[name];
-           as_struct->selfReferencing =  nodes[id]->isActive();
-           as_struct->uid = ptr;
-           myDeclaration = as_struct;
+           StructEntry newEntry {
+             helpNode,
+             registry.structRegistry.size(),
+             std::make_shared<llvm::Type*>(nullptr),
+             std::make_shared<StructLayout>()
+           };
+           entry = registry.structRegistry.insert(std::make_pair(helpNode.get(), newEntry)).first;
          }
+         auto shared = entry->second;
+         lock.unlock();
+         auto as_struct = make_shared<StructDeclaration>(name, helpNode, helpNode->isActive());
+         as_struct->llvm_type = shared.llvm_type;
+         as_struct->layout = shared.layout;
+         as_struct->uid = shared.uid;
+         myDeclaration = as_struct;
        } else {
           throw Parsing::ParsingException("the struct @" + type + "is not defined", pos);
        }
@@ -351,7 +394,9 @@ SemanticDeclarationNode SemanticTree::helpConvert(
 
      int pointerCounter = res.first;
     if (pointerCounter != 0) {
-      myDeclaration =  make_shared<PointerDeclaration>(pointerCounter-1, myDeclaration);
+      auto pointer = make_shared<PointerDeclaration>(pointerCounter-1, myDeclaration);
+      pointer->restrictQualified = declarator->isRestrict();
+      myDeclaration = pointer;
     } 
 
    } else {
@@ -361,7 +406,9 @@ SemanticDeclarationNode SemanticTree::helpConvert(
      myDeclaration = createType(typeNode, pos);
 
     if (pointerCounter != 0) {
-      myDeclaration =  make_shared<PointerDeclaration>(pointerCounter-1, myDeclaration);
+      auto pointer = make_shared<PointerDeclaration>(pointerCounter-1, myDeclaration);
+      pointer->restrictQualified = declarator->isRestrict();
+      myDeclaration = pointer;
     }  else {
 
       auto s =  myDeclaration;
@@ -419,8 +466,8 @@ SemanticDeclarationNode SemanticTree::addDeclaration(TypeNode typeNode, SubDecla
     // std::cout<<" DECL : "<<name<<" : " <<decl->toString()<<std::endl;
   
     // don't allow functions inside a struct 
-    if (nodes[currentPos]->isInsideStruct()) {
-      debug(SEMANTIC)  <<"current pos " <<currentPos;
+    if (scopes.back()->isInsideStruct()) {
+      debug(SEMANTIC)  <<"current depth " <<declarations.depth();
       if(!Semantic::isObjectType(decl)) {
       throw ParsingException("A function definition is not allowed inside a struct ", pos);
       }
@@ -450,11 +497,12 @@ SemanticDeclarationNode SemanticTree::addDeclaration(TypeNode typeNode, SubDecla
 
     // add function to map
     if (decl->type() == Semantic::Type::FUNCTION) {
-      if (functionMap.find(name) == functionMap.end()){
+      auto previousFunction = findFunction(name);
+      if (!previousFunction) {
           functionMap[name] = make_pair(decl, isForwardFunction);
       } else {
-        bool wasForward = functionMap[name].second;
-        auto lastDecl = functionMap[name].first; 
+        bool wasForward = previousFunction->second;
+        auto lastDecl = previousFunction->first; 
         if (!hasSameType(lastDecl, decl)) {
           throw Parsing::ParsingException("the functions do not have the same type ", pos);
         } else {
@@ -462,6 +510,7 @@ SemanticDeclarationNode SemanticTree::addDeclaration(TypeNode typeNode, SubDecla
         }
 
         if (wasForward) {
+          // a fork records this in its own map
           functionMap[name] = make_pair(decl, isForwardFunction);
         } else {
           if (!isForwardFunction) {
@@ -472,41 +521,29 @@ SemanticDeclarationNode SemanticTree::addDeclaration(TypeNode typeNode, SubDecla
 
     }
 
-    // This is the old code 
-    TypeStack *st;
-
     if (name == "NONAME") {
       return decl;
     }
 
-    if (declarationMap.find(name) == declarationMap.end()) {
-      st = new stack<pair<int, SemanticDeclarationNode> >();
-      st->push(make_pair(currentPos, decl ));
-      nodes[currentPos]->addDeclaration(name, decl);
-      declarationMap[name] = st;
-    } else {
-      st = declarationMap[name];
-
-      deleteNotActiveNodes(st);
+    auto previous = declarations.find(name);
+    // NO redefinitions
+    if (previous && previous->depth == declarations.depth()) {
 
-      // NO redefinitions
-      if (!st->empty() && st->top().first == currentPos) {
+      auto prevDecl = previous->value;
 
-        auto prevDecl = st->top().second;
-
-        if (!hasSameType(prevDecl, decl)) {
-          throw Parsing::ParsingException("the declaration of  " + name + " has not the same type", pos);
-        }
-
-        if (decl->type() !=  Semantic::Type::FUNCTION && currentPos != 0) {
-          throw Parsing::ParsingException("no redefinition of " + name, pos);
-        }
-        decl = prevDecl;
-      } 
+      if (!hasSameType(prevDecl, decl)) {
+        throw Parsing::ParsingException("the declaration of  " + name + " has not the same type", pos);
+      }
 
-      declarationMap[name]->push(make_pair(currentPos, decl ));
-      nodes[currentPos]->addDeclaration(name, decl);
+      if (decl->type() !=  Semantic::Type::FUNCTION && declarations.depth() != 0) {
+        throw Parsing::ParsingException("no redefinition of " + name, pos);
+      }
+      // the binding in this scope stays the same
+      return prevDecl;
     }
+
+    declarations.bind(name, decl);
+    scopes.back()->addDeclaration(name, decl);
     return decl;
   } else {
     // TODO should this throw an error ?
@@ -515,30 +552,47 @@ SemanticDeclarationNode SemanticTree::addDeclaration(TypeNode typeNode, SubDecla
 }
 
 SemanticDeclarationNode SemanticTree::lookUpType(string name, Pos pos) {
-  if (declarationMap.find(name) != declarationMap.end()) {
-    TypeStack *st =  declarationMap[name];
-
-    deleteNotActiveNodes(st);
-    // delete not active nodes
-
-    if (st->empty()) {
-      throw Parsing::ParsingException(name+ " is not declared in this scope", pos);
-    } else {
-      return st->top().second;
-    }
-  } else {
+  auto binding = declarations.find(name);
+  if (!binding && fileScope) {
+    binding = fileScope->declarations.find(name, visibleDeclarations);
+  }
+  if (!binding) {
     throw Parsing::ParsingException(name+ " is not declared in this scope", pos);
   }
+  return binding->value;
+}
+
+/*====CompilationContext======*/
+
+namespace {
+  thread_local CompilationContext* currentContext = nullptr;
 }
 
-shared_ptr<SemanticTree> SemanticForest::filename2SemanticTree(std::string filename)
+CompilationContext::CompilationContext()
+  : semanticTree(new SemanticTree()) {}
+
+CompilationContext & CompilationContext::current()
 {
-  static auto names2trees = map<std::string, shared_ptr<SemanticTree>>();
-  if (names2trees.find(filename) == names2trees.end()) {
-        auto tree = shared_ptr<SemanticTree>(new SemanticTree());
-        names2trees[filename] = tree;
+  if (!currentContext) {
+    throw std::logic_error("no compilation context is active");
   }
-  return names2trees[filename];
+  return *currentContext;
+}
+
+CompilationContext::Activation::Activation(CompilationContext & context)
+  : previous(currentContext)
+{
+  currentContext = &context;
+}
+
+CompilationContext::Activation::~Activation()
+{
+  currentContext = previous;
+}
+
+Semantic::TypeContext & Semantic::types()
+{
+  return CompilationContext::current().types;
 }
 
 namespace Semantic {
@@ -569,11 +623,15 @@ bool hasScalarType(SubExpression s) {
 bool isArithmeticType(SemanticDeclarationNode s) {
   /* As we don't support floading point types,
    * arithmetic types are limited to integral types.
-   * Those are limited to char and int in our implementation
+   * Those are limited to char, int, long and their unsigned variants in our
+   * implementation
    */
   switch (s->type()) {
     case Type::INT:
     case Type::CHAR:
+    case Type::LONG:
+    case Type::UNSIGNED:
+    case Type::UNSIGNED_LONG:
       return true;
     default:
       return false;
@@ -590,6 +648,9 @@ bool isIntegerType(SemanticDeclarationNode s) {
   switch (s->type()) {
     case Type::INT:
     case Type::CHAR:
+    case Type::LONG:
+    case Type::UNSIGNED:
+    case Type::UNSIGNED_LONG:
       return true;
     default:
       return false;
@@ -598,6 +659,27 @@ bool isIntegerType(SemanticDeclarationNode s) {
 bool hasIntegerType(SubExpression s) {
   return isIntegerType(s->getType());
 }
+bool isUnsignedType(SemanticDeclarationNode s) {
+  // char is signed, as on the hosts we target
+  switch (s->type()) {
+    case Type::UNSIGNED:
+    case Type::UNSIGNED_LONG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// the integer conversion rank of 6.3.1.1, after the integer promotions
+static int integerRank(SemanticDeclarationNode s) {
+  switch (s->type()) {
+    case Type::LONG:
+    case Type::UNSIGNED_LONG:
+      return 2;
+    default:
+      return 1;
+  }
+}
 
 bool isRealType(SemanticDeclarationNode s) {
   return isArithmeticType(s);
@@ -608,10 +690,10 @@ bool hasRealType(SubExpression s) {
 bool isNullPtrConstant(SubExpression s);
 
 bool isNullPtrConstant(SubExpression s) {
-  if (auto s_as_constant = dynamic_pointer_cast<Constant>(s)) {
-    if (dynamic_pointer_cast<NullDeclaration>(s_as_constant->getType())) {
-      return true;
-    }
+  // only constants have the null type, unless it was propagated by an
+  // operator; in that case the expression is no null pointer constant
+  if (s->getType() == types().nullType()) {
+    return static_cast<bool>(dynamic_pointer_cast<Constant>(s));
   }
   return false;
 }
@@ -656,8 +738,8 @@ SemanticDeclarationNode promoteType(SemanticDeclarationNode s) {
   // FIXME: note that this function doesn't really do type promotion
   // for this it would need both types
   // and more semantic knowledge
-  if (dynamic_pointer_cast<CharDeclaration>(s)) {
-    return make_shared<IntDeclaration>();
+  if (s->type() == Type::CHAR) {
+    return types().intType();
   }
   return s;
 }
@@ -665,34 +747,40 @@ SemanticDeclarationNode promoteType(SemanticDeclarationNode s) {
   std::pair<SemanticDeclarationNode, SemanticDeclarationNode> applyUsualConversions(SemanticDeclarationNode s1,SemanticDeclarationNode s2)
 {
   //6.3.1.8 Usual arithmetic conversions
-  // many rules which are not relevant, because we have no unsigned and only int
-  // + char
+  // only the rules for integers are relevant, as we have no floating types
+  // the integer promotions are performed on both operands: char -> int
+  s1 = promoteType(s1);
+  s2 = promoteType(s2);
+  // If both operands have the same type, then no further conversion is needed.
   if (compareTypes(s1, s2)) {
-    if (s1->type() == Semantic::Type::CHAR) {
-      auto int_type = make_shared<IntDeclaration>();
-      return make_pair(int_type, int_type);
-    }
     return make_pair<>(s1,s2);
   }
-  // else
-  // If both operands have the same type, then no further conversion is needed.
+  if (!isIntegerType(s1) || !isIntegerType(s2)) {
+    // the other rules don't apply in our limited subset
+    return make_pair<>(s1,s2);
+  }
   //Otherwise, if both operands have signed integer types or both have unsigned
   //integer types, the operand with the type of lesser integer conversion rank is
   //converted to the type of the operand with greater rank.
-  // ==> in our case: char -> int
-  auto s1_type = s1->type();
-  auto s2_type = s2->type();
-  if (s1_type == Type::INT && s2_type == Type::CHAR) {
-    auto int_type = make_shared<IntDeclaration>();
-    return make_pair<>(s1, int_type);
-  }
-  if (s2_type == Type::INT && s1_type == Type::CHAR) {
-    auto int_type = make_shared<IntDeclaration>();
-    return make_pair<>(int_type, s2);
+  //Otherwise, if the operand that has unsigned integer type has rank greater or
+  //equal to the rank of the type of the other operand, then the operand with
+  //signed integer type is converted to the type of the operand with unsigned
+  //integer type.
+  //Otherwise, if the type of the operand with signed integer type can represent
+  //all of the values of the type of the operand with unsigned integer type,
+  //then the operand with unsigned integer type is converted to the type of the
+  //operand with signed integer type.
+  // ==> as long is wider than unsigned int, the last rule always applies
+  SemanticDeclarationNode common;
+  if (isUnsignedType(s1) == isUnsignedType(s2)) {
+    common = (integerRank(s1) >= integerRank(s2)) ? s1 : s2;
+  } else {
+    auto unsigned_type = isUnsignedType(s1) ? s1 : s2;
+    auto signed_type = isUnsignedType(s1) ? s2 : s1;
+    common = (integerRank(unsigned_type) >= integerRank(signed_type))
+      ? unsigned_type : signed_type;
   }
-  // the other rules don't apply in our limited subset
-  // TODO: throw an exception in that case?
-  return make_pair<>(s1,s2);
+  return make_pair<>(common, common);
 }
 
 }
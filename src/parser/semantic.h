@@ -5,8 +5,8 @@
 #include <map>
 #include <set>
 #include <vector>
-#include <stack>
 #include <memory>
+#include <mutex>
 #include "../utils/datastructures.h"
 #include "../utils/pos.h"
 #include "astNode.h"
@@ -25,69 +25,159 @@ class SemanticException: public std::runtime_error {
 class SemanticNode;
 typedef std::shared_ptr<SemanticNode> SubSemanticNode;
 
-typedef std::stack<std::pair<int, Parsing::SemanticDeclarationNode> > TypeStack;
-
 class SemanticNode {
   public:
-    SemanticNode(int parent, bool insideStruct, bool forward = false);
+    SemanticNode(bool insideStruct, bool forward = false);
 
     void disable();
-    int getParentIndex();
     bool isActive();
+    // also true for a struct a snapshot sees before its completion
     bool isForward();
-    void setNotForward();
+    // completion numbers the file scope structs in the order they were
+    // completed, 0 means the struct is complete in every snapshot
+    void setNotForward(size_t completion = 0);
     void addDeclaration(std::string s, Parsing::SemanticDeclarationNode node);
 
     // TODO: make this private and a friend of StructDeclaration?
-    std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> type(); 
+    const std::vector<std::pair<std::string, Parsing::SemanticDeclarationNode>> & type(); 
 
     bool isInsideStruct();
+    // drops all declarations; breaks the reference cycles of self-referencing
+    // structs when the translation unit is done
+    void clear();
 
     Parsing::SemanticDeclarationNode getNode(std::string name);
+    // same as above, but also stores the position of the member in index
+    Parsing::SemanticDeclarationNode getNode(std::string name, unsigned &index);
 
   private:
-    int parent;
     bool active;
     bool insideStruct;
     bool forward;
+    size_t completion;
     util::InsertionOrderPreservingMap<std::string, Parsing::SemanticDeclarationNode> decl;
 };
 
 class SemanticTree;
 
-class SemanticForest {
+/*
+ * Owns everything the semantic analysis of one translation unit creates: the
+ * symbol tables and the struct registry (both in the SemanticTree) and the
+ * type context. Nothing is shared between translation units, so several
+ * contexts can be used on different threads at the same time.
+ *
+ * The AST and the code generator reach the context of the translation unit
+ * they work on through current(), which is set by an Activation.
+ */
+class CompilationContext {
   public:
-    static std::shared_ptr<SemanticTree> filename2SemanticTree(std::string filename);
+    CompilationContext();
+    CompilationContext(const CompilationContext &) = delete;
+    CompilationContext & operator=(const CompilationContext &) = delete;
+
+    std::shared_ptr<SemanticTree> semanticTree;
+    Semantic::TypeContext types;
+
+    // the context activated on this thread
+    static CompilationContext & current();
+
+    // makes a context the current one of this thread while it is alive
+    class Activation {
+      public:
+        explicit Activation(CompilationContext & context);
+        ~Activation();
+        Activation(const Activation &) = delete;
+        Activation & operator=(const Activation &) = delete;
+      private:
+        CompilationContext* previous;
+    };
 };
 
 class SemanticTree {
-  friend class SemanticForest;
+  friend class CompilationContext;
 
   private:
     SemanticTree();
-    std::vector<std::shared_ptr<SemanticNode> > nodes;
-    int currentPos;
+    // what all StructDeclarations of one struct definition share
+    struct StructEntry {
+      SubSemanticNode node;
+      size_t uid;
+      std::shared_ptr<llvm::Type*> llvm_type;
+      std::shared_ptr<StructLayout> layout;
+    };
+    // one entry per struct definition, keyed by the struct's scope; forks
+    // register their structs here as well
+    std::map<SemanticNode*, StructEntry> structRegistry;
+    std::mutex structRegistryMutex;
+    // how many forward declared structs of the file scope were completed
+    size_t completedStructs;
+    // the currently open scopes, the innermost one is at the back
+    std::vector<SubSemanticNode> scopes;
     Parsing::SemanticDeclarationNode m_currentFunction;
-    int counter;
-    std::map<std::string, TypeStack *> declarationMap;
-    std::map<std::string, std::stack<std::pair<int,bool> > > structMap;
+    util::ScopedSymbolTable<Parsing::SemanticDeclarationNode> declarations;
+    // struct tags, prefixed with @
+    util::ScopedSymbolTable<SubSemanticNode> structs;
     std::map<std::string, std::pair<SemanticDeclarationNode, bool> > functionMap;
     int loopDepth; // depth inside loop for checking break; continue;
+    // the labels of the enclosing switch statements, the innermost at the back
+    struct SwitchLabels {
+      std::set<int> cases;
+      bool hasDefault;
+    };
+    std::vector<SwitchLabels> switches;
 
     // map for goto 
     std::set<std::string> labelMap;
     std::vector<std::pair<std::string, Pos>> gotoLabels;
 
+    // set in forks: the tree whose file scope they see, and how many of its
+    // declarations, struct tags and completed structs existed when the fork
+    // was made
+    SemanticTree* fileScope = nullptr;
+    size_t visibleDeclarations;
+    size_t visibleStructs;
+    size_t visibleCompletions;
+
+    SemanticTree & root();
+    util::ScopedSymbolTable<SubSemanticNode>::Binding* findStruct(std::string name);
+    std::pair<SemanticDeclarationNode, bool>* findFunction(std::string name);
+
   public:
-    ~SemanticTree(); // we hold pointers in the declarationMap which we need to free
+    ~SemanticTree();
+    /*
+     * Returns a tree for checking a function body apart from this one, e.g. on
+     * another thread: it has a private stack of block scopes on top of the
+     * file scope of this tree. Declarations added to this tree later on are
+     * not visible in the fork; a fork must not be used while declarations
+     * are still added to this tree on another thread.
+     */
+    std::shared_ptr<SemanticTree> fork();
+    /*
+     * While a snapshot of a fork is alive, the structs of the file scope look
+     * on this thread as they did when the fork was made: a struct completed
+     * afterwards is still incomplete, as it would be without the fork
+     */
+    class Snapshot {
+      public:
+        explicit Snapshot(const SemanticTree & fork);
+        ~Snapshot();
+        Snapshot(const Snapshot &) = delete;
+        Snapshot & operator=(const Snapshot &) = delete;
+      private:
+        size_t previous;
+    };
     // returns true, if the label could be added
     bool addLabel(std::string label);
     void addChild(Pos pos, std::string name="@@", bool forward = false);
     void goUp();
-    void deleteNotActiveNodes(TypeStack *st);
     Parsing::SemanticDeclarationNode addDeclaration(TypeNode typeNode, SubDeclarator declarator, Pos pos, bool forwardFunction = true);
     void increaseLoopDepth();
     void decreaseLoopDepth();
+    void enterSwitch();
+    void leaveSwitch();
+    // throw if the label is not inside a switch or repeats one of its labels
+    void addCaseLabel(int value, Pos pos);
+    void addDefaultLabel(Pos pos);
     /*
      * set and unset the current function type
      * this is used when entering a function definition to check that the return
@@ -98,6 +188,8 @@ class SemanticTree {
     Parsing::SemanticDeclarationNode currentFunction();
     void addGotoLabel(std::string str, Pos pos);
     bool isInLoop();
+    // whether break may be used: inside of a loop or switch
+    bool isBreakable();
     Parsing::SemanticDeclarationNode createType(TypeNode t, Pos pos);
     Parsing::SemanticDeclarationNode helpConvert(
   TypeNode typeNode, 
@@ -106,6 +198,8 @@ class SemanticTree {
 
     // tells whether a struct has already been declared
     bool hasStructDeclaration(std::string name);
+    // tells whether the function has a definition so far
+    bool isDefinedFunction(std::string name);
 
     void checkGotoLabels();
     Parsing::SemanticDeclarationNode lookUpType(std::string name, Pos pos);
@@ -121,6 +215,7 @@ namespace Semantic {
   bool hasArithmeticType(Parsing::SubExpression);
   bool isIntegerType(Parsing::SemanticDeclarationNode);
   bool hasIntegerType(Parsing::SubExpression);
+  bool isUnsignedType(Parsing::SemanticDeclarationNode);
   bool isRealType(Parsing::SemanticDeclarationNode);
   bool hasRealType(Parsing::SubExpression);
   bool isNullPtrConstant(Parsing::SubExpression s);
@@ -13,6 +13,13 @@ typedef std::shared_ptr<Expression> SubExpression;
 class ASTNODE(Statement) 
 {
   CONS_INTER(Statement)
+  public:
+    /* whether goto can jump into the statement, so that it can be reached
+     * even if the code before it cannot */
+    virtual bool containsLabel() {return false;}
+    /* whether the enclosing switch can jump into the statement; the case
+     * labels of a nested switch belong to that switch */
+    virtual bool containsCaseLabel() {return false;}
 };
 
 typedef std::shared_ptr<Statement> SubStatement;
@@ -23,6 +30,11 @@ class STATEMENT(CompoundStatement) {
     CompoundStatement(std::vector<BlockItem> subStatements, Pos pos);
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
+    bool containsLabel() override;
+    bool containsCaseLabel() override;
+    // analyzes the block items in the innermost scope of semanticTree
+    void analyzeItems(SemanticTree & semanticTree);
   private:
     std::vector<BlockItem> subStatements;
 };
@@ -33,6 +45,7 @@ class STATEMENT(ExpressionStatement) {
     ExpressionStatement(SubExpression ex, Pos pos);
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
 
   private:
     SubExpression expression;
@@ -51,6 +64,9 @@ class STATEMENT(SelectionStatement) {
   public:
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
+    bool containsLabel() override;
+    bool containsCaseLabel() override;
     SelectionStatement(SubExpression ex, SubStatement ifStatement, Pos pos);
     SelectionStatement(
       SubExpression ex, 
@@ -74,6 +90,7 @@ class JUMPSTATEMENT(GotoStatement) {
   public:
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
     GotoStatement(std::string label, Pos pos);
 
   private:
@@ -84,6 +101,7 @@ class JUMPSTATEMENT(ContinueStatement) {
   public:
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
     ContinueStatement(Pos pos);
 };
 
@@ -91,6 +109,7 @@ class JUMPSTATEMENT(BreakStatement) {
   public:
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
     BreakStatement(Pos pos);
 };
 
@@ -98,18 +117,22 @@ class JUMPSTATEMENT(ReturnStatement) {
   public:
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
     ReturnStatement(Pos pos);
     ReturnStatement(SubExpression ex, Pos pos);
   
   private:
     SubExpression expression;
-    void verifyReturnType(SubExpression returnExp);
+    // the type the value is converted to, which is the one of the function
+    SemanticDeclarationNode returnType;
+    void verifyReturnType(SubExpression returnExp, SemanticTree & semanticTree);
 };
 
 // iteration statement i.e. while and for
 enum IterationEnum {
   WHILE,
-  DOWHILE
+  DOWHILE,
+  FOR
 };
 typedef std::shared_ptr<JumpStatement> SubJumpStatement;
 typedef std::shared_ptr<CompoundStatement> SubCompoundStatement;
@@ -117,26 +140,41 @@ typedef std::shared_ptr<ExpressionStatement> SubExpressionStatement;
  
 typedef std::shared_ptr<SelectionStatement> SubSelectionStatement;
 
-// while, do while
+// while, do while, for
 class STATEMENT(IterationStatement) { 
   public:
     IterationStatement(SubExpression ex,
         SubStatement st,
         IterationEnum k,
         Pos pos);
+    // a for loop; each of the expressions may be null
+    IterationStatement(SubExpression init,
+        SubExpression ex,
+        SubExpression step,
+        SubStatement st,
+        Pos pos);
     PPRINTABLE
     IR_EMITTING
+    ANALYZABLE
+    bool containsLabel() override;
+    bool containsCaseLabel() override;
 
   private:
     SubExpression expression;
     SubStatement statement;
     IterationEnum kind;
+    // only for for loops
+    SubExpression init;
+    SubExpression step;
 };
 
 class STATEMENT(LabeledStatement) {
   public:
     LabeledStatement(std::string str, SubStatement st, Pos pos);
     PPRINTABLE
+    ANALYZABLE
+    bool containsLabel() override {return true;}
+    bool containsCaseLabel() override {return statement->containsCaseLabel();}
 
   private:
     std::string name;
@@ -144,6 +182,38 @@ class STATEMENT(LabeledStatement) {
     IR_EMITTING
 };
 
+/* switch "(" expression ")" statement; the statement is entered at the case
+ * labels inside of it */
+class STATEMENT(SwitchStatement) {
+  public:
+    SwitchStatement(SubExpression ex, SubStatement st, Pos pos);
+    PPRINTABLE
+    IR_EMITTING
+    ANALYZABLE
+    bool containsLabel() override;
+
+  private:
+    SubExpression expression;
+    SubStatement statement;
+};
+
+// a case label, or the default label if there is no expression
+class STATEMENT(CaseStatement) {
+  public:
+    CaseStatement(SubExpression ex, SubStatement st, Pos pos);
+    CaseStatement(SubStatement st, Pos pos);
+    PPRINTABLE
+    IR_EMITTING
+    ANALYZABLE
+    bool containsLabel() override {return statement->containsLabel();}
+    // the switch jumps to it
+    bool containsCaseLabel() override {return true;}
+
+  private:
+    SubExpression expression;
+    SubStatement statement;
+};
+
 typedef std::shared_ptr<LabeledStatement> SubLabeledStatement;
 typedef std::shared_ptr<IterationStatement> SubIterationStatement;
 
@@ -32,7 +32,10 @@ class TYPE(BasicType) {
     enum ReturnType {
       VOID,
       INT,
-      CHAR
+      CHAR,
+      LONG,
+      UNSIGNED,
+      UNSIGNED_LONG
     };
 
     ReturnType type;
@@ -3,6 +3,11 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <stdexcept>
+#include <utility>
+#include <string>
+#include <functional>
 #include <algorithm>
 #include <exception>
 
@@ -15,21 +20,23 @@ namespace util {
 
 /*
  * A map which, unlike std::map, preserves the order of insertions
- * Internally, a vector is used
+ * The entries are stored in a vector, which gives stable iteration in
+ * insertion order; an unordered_map from the key to the position inside the
+ * vector provides lookups in O(1) on average
  */
-template<typename Key, typename Value>
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
 class InsertionOrderPreservingMap
 {
   private:
     std::vector<std::pair<Key,Value>> mapping;
+    std::unordered_map<Key, size_t, Hash> positions;
 
     auto find_pos(const Key & key) -> decltype(mapping.end()) {
-      return std::find_if(
-        mapping.begin(),
-        mapping.end(),
-        [&](std::pair<Key,Value> & pair) {
-          return key == pair.first;
-      });
+      auto pos = positions.find(key);
+      if (pos == positions.end()) {
+        return mapping.end();
+      }
+      return mapping.begin() + pos->second;
     }
   public:
     auto begin() -> decltype(mapping.begin()) {
@@ -39,33 +46,45 @@ class InsertionOrderPreservingMap
       return mapping.end();
     }
 
-    auto as_list() -> decltype(mapping) {return mapping;}
+    auto as_list() const -> const decltype(mapping) & {return mapping;}
+
+    auto size() const -> decltype(mapping.size()) {
+      return mapping.size();
+    }
 
-    auto operator[](const Key & key) -> decltype(std::map<Key, Value> {}.at(key)) {
-      auto pos = find_pos(key);
-      if (pos == mapping.end()) {
-        auto new_elem = std::make_pair(key, Value {});
-        mapping.push_back(new_elem);
-        return (--mapping.end())->second;
+    Value & operator[](const Key & key) {
+      auto pos = positions.find(key);
+      if (pos == positions.end()) {
+        positions.emplace(key, mapping.size());
+        mapping.emplace_back(key, Value {});
+        return mapping.back().second;
       }
-      return pos->second;
+      return mapping[pos->second].second;
     }
 
-    auto at(const Key & key) -> decltype(this->operator[](key)) {
-      auto pos = find_pos(key);
-      if (pos == mapping.end()) {
+    Value & at(const Key & key) {
+      auto pos = positions.find(key);
+      if (pos == positions.end()) {
         throw std::out_of_range("Member not found!");
       }
-      return *pos;
+      return mapping[pos->second].second;
     }
 
+    /* returns the position of key in insertion order, or -1 */
+    long index_of(const Key & key) const {
+      auto pos = positions.find(key);
+      return (pos == positions.end()) ? -1 : static_cast<long>(pos->second);
+    }
 
     auto empty() -> decltype(mapping.empty()) {
       return mapping.empty();
     }
 
-    auto insert(std::pair<Key,Value> elem) -> decltype(mapping.push_back(elem)) {
-      mapping.push_back(elem);
+    /* like std::map, an already present key keeps its value */
+    void insert(std::pair<Key,Value> elem) {
+      if (positions.emplace(elem.first, mapping.size()).second) {
+        mapping.push_back(std::move(elem));
+      }
     }
 
     auto find(const Key & key) -> decltype(mapping.end()) {
@@ -73,5 +92,150 @@ class InsertionOrderPreservingMap
     }
 };
 
+/*
+ * A symbol table for block structured languages
+ *
+ * Names are interned once into an open addressing hash table; every interned
+ * symbol points to its innermost visible binding, which in turn remembers the
+ * binding it shadows. Bindings are kept on a stack which doubles as the undo
+ * log of the scopes: leaving a scope pops exactly the bindings made inside it
+ * and restores the shadowed ones. Therefore lookups never have to skip dead
+ * entries and their cost does not depend on the number of scopes which were
+ * opened before.
+ */
+template<typename Value>
+class ScopedSymbolTable
+{
+  public:
+    struct Binding {
+      Value value;
+      unsigned depth; // nesting depth of the scope containing the binding
+      int shadowed;   // index of the shadowed binding or -1
+      unsigned symbol;
+    };
+
+  private:
+    struct Symbol {
+      std::string name;
+      size_t hash;
+      int innermost; // index into bindings or -1
+    };
+
+    enum : unsigned { EMPTY = 0 };
+
+    // 0 marks an empty slot, otherwise the slot contains symbol index + 1
+    std::vector<unsigned> slots;
+    std::vector<Symbol> symbols;
+    std::vector<Binding> bindings;
+    std::vector<size_t> scopeMarks;
+
+    size_t probe(const std::string & name, size_t hash) const {
+      auto mask = slots.size() - 1;
+      auto pos = hash & mask;
+      while (slots[pos] != EMPTY) {
+        auto const & symbol = symbols[slots[pos] - 1];
+        if (symbol.hash == hash && symbol.name == name) {
+          break;
+        }
+        pos = (pos + 1) & mask;
+      }
+      return pos;
+    }
+
+    void grow() {
+      std::vector<unsigned> old(slots.size() * 2, EMPTY);
+      old.swap(slots);
+      auto mask = slots.size() - 1;
+      for (unsigned i = 0; i < symbols.size(); ++i) {
+        auto pos = symbols[i].hash & mask;
+        while (slots[pos] != EMPTY) {
+          pos = (pos + 1) & mask;
+        }
+        slots[pos] = i + 1;
+      }
+    }
+
+  public:
+    ScopedSymbolTable() : slots(64, EMPTY) {}
+
+    /* returns a dense id for name, which stays valid for the table's lifetime */
+    unsigned intern(const std::string & name) {
+      auto hash = std::hash<std::string>()(name);
+      auto pos = probe(name, hash);
+      if (slots[pos] != EMPTY) {
+        return slots[pos] - 1;
+      }
+      symbols.push_back(Symbol {name, hash, -1});
+      slots[pos] = symbols.size();
+      // keep the load factor below 1/2, so that probe sequences stay short
+      if (2 * symbols.size() > slots.size()) {
+        grow();
+      }
+      return symbols.size() - 1;
+    }
+
+    /* returns the innermost visible binding of name or nullptr */
+    Binding* find(const std::string & name) {
+      auto pos = probe(name, std::hash<std::string>()(name));
+      if (slots[pos] == EMPTY) {
+        return nullptr;
+      }
+      return find(slots[pos] - 1);
+    }
+
+    Binding* find(unsigned symbol) {
+      auto innermost = symbols[symbol].innermost;
+      return (innermost < 0) ? nullptr : &bindings[innermost];
+    }
+
+    /*
+     * like find, but only sees the first count bindings that were made, i.e.
+     * the table as it was when size() returned count; only reads the table
+     */
+    Binding* find(const std::string & name, size_t count) {
+      auto pos = probe(name, std::hash<std::string>()(name));
+      if (slots[pos] == EMPTY) {
+        return nullptr;
+      }
+      auto index = symbols[slots[pos] - 1].innermost;
+      while (index >= 0 && static_cast<size_t>(index) >= count) {
+        index = bindings[index].shadowed;
+      }
+      return (index < 0) ? nullptr : &bindings[index];
+    }
+
+    /* number of live bindings; they are numbered in the order of bind */
+    size_t size() const {
+      return bindings.size();
+    }
+
+    /* binds name in the current scope, shadowing any outer binding */
+    void bind(const std::string & name, Value value) {
+      auto symbol = intern(name);
+      bindings.push_back(Binding {value, depth(), symbols[symbol].innermost, symbol});
+      symbols[symbol].innermost = bindings.size() - 1;
+    }
+
+    void pushScope() {
+      scopeMarks.push_back(bindings.size());
+    }
+
+    /* drops all bindings of the innermost scope */
+    void popScope() {
+      auto mark = scopeMarks.back();
+      scopeMarks.pop_back();
+      while (bindings.size() > mark) {
+        auto const & binding = bindings.back();
+        symbols[binding.symbol].innermost = binding.shadowed;
+        bindings.pop_back();
+      }
+    }
+
+    /* 0 is the outermost scope */
+    unsigned depth() const {
+      return scopeMarks.size();
+    }
+};
+
 }
 #endif
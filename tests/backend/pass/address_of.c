@@ -0,0 +1,25 @@
+struct point {
+  int x;
+  int y;
+};
+
+int main(void)
+{
+  struct point s;
+  struct point *p;
+  int *q;
+  int a;
+  int b;
+  // only s and a are address taken, p and b can live in registers
+  p = &s;
+  q = &s.y;
+  *q = 2;
+  q = &p->x;
+  *q = 1;
+  a = 3;
+  q = &*&a;
+  b = *q;
+  p = &*p;
+  q = &p->y;
+  return s.x + s.y + a - b - *q - 1;
+}
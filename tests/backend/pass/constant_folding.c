@@ -0,0 +1,13 @@
+int f(void) {
+  return 100;
+}
+
+int main(void) {
+  int x;
+  x = 2 * 3 + 4 * (10 - 1) - -('b' - 'b');
+  if (0 && f())
+    x = 0;
+  if (1 || f())
+    x = x + (1 == 2) + (3 != 3);
+  return (1 < 2 ? x : f()) + sizeof(char) - 1 + !5 + (0 ? f() : 0);
+}
@@ -0,0 +1,47 @@
+int sum(int n)
+{
+  int i;
+  int total;
+  total = 0;
+  for (i = 0; i < n; i = i + 1) {
+    if (i == 3)
+      continue;
+    total = total + i;
+  }
+  return total;
+}
+
+int first(int n)
+{
+  int i;
+  for (i = 1; ; i = i * 2) {
+    if (n < i)
+      break;
+  }
+  return i;
+}
+
+int nested(int n)
+{
+  int i;
+  int j;
+  int count;
+  count = 0;
+  for (i = 0; i < n; i = i + 1)
+    for (j = 0; j < i; j = j + 1)
+      count = count + 1;
+  return count;
+}
+
+int main(void)
+{
+  int i;
+  i = 7;
+  // the body of a loop whose condition is false at first never runs
+  for (; i < 5; )
+    i = 0;
+  do
+    i = i - 1;
+  while (0);
+  return sum(6) + first(5) + nested(4) + i - 32;
+}
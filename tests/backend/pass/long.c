@@ -0,0 +1,53 @@
+long square(long x)
+{
+  return x * x;
+}
+
+int count(char *s, unsigned long n)
+{
+  unsigned long i;
+  int found;
+  found = 0;
+  for (i = 0; i < n; i = i + 1)
+    if (s[i] == 'l')
+      found = found + 1;
+  return found;
+}
+
+int main(void)
+{
+  long big;
+  unsigned int u;
+  unsigned long size;
+  char *s;
+  char *t;
+  int result;
+  result = 0;
+  // does not fit into 32 bits
+  big = square(100000);
+  if (big != 10000000000)
+    result = result + 1;
+  // wraps around instead of being negative
+  u = 0;
+  u = u - 1;
+  if (u < 1)
+    result = result + 1;
+  // the int is converted to unsigned int
+  if (-1 < u)
+    result = result + 1;
+  // but to long, which holds all unsigned ints
+  big = -1;
+  if (u < big)
+    result = result + 1;
+  size = sizeof(long) + sizeof(unsigned int) + sizeof(unsigned long int);
+  if (size != 20)
+    result = result + 1;
+  s = "hello world";
+  t = s + 9;
+  if (t - s != 9)
+    result = result + 1;
+  big = 4;
+  if (s[big] != 'o')
+    result = result + 1;
+  return result + count(s, 11) - 3;
+}
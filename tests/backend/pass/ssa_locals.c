@@ -0,0 +1,66 @@
+int sum(int *p, int n)
+{
+  int s;
+  int i;
+  s = 0;
+  i = 0;
+  while (i < n) {
+    if (p[i] == 0) {
+      i = i + 1;
+      continue;
+    }
+    s = s + p[i];
+    i = i + 1;
+  }
+  return s;
+}
+
+int nested(int n)
+{
+  int i;
+  int j;
+  int c;
+  c = 0;
+  i = 0;
+  while (i < n) {
+    j = 0;
+    do {
+      if (j == 3)
+        break;
+      c = c + (i < j ? i : j);
+      j = j + 1;
+    } while (j < n);
+    if (c == 42)
+      break;
+    i = i + 1;
+  }
+  return c;
+}
+
+int countdown(char n)
+{
+  int steps;
+  steps = 0;
+again:
+  if (n == 0)
+    return steps;
+  n = n - 1;
+  steps = steps + 1;
+  goto again;
+}
+
+int escaping(void)
+{
+  int x;
+  int *p;
+  x = 1;
+  p = &x;
+  *p = 2;
+  return x;
+}
+
+int main(void)
+{
+  int uninitialized;
+  return nested(5) + countdown(3) + escaping() - uninitialized * 0;
+}
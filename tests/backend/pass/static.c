@@ -0,0 +1,28 @@
+static int limit;
+static int counter;
+int exported;
+
+static int square(int x);
+
+int square(int x)
+{
+  return x * x;
+}
+
+static int step(void)
+{
+  counter = counter + 1;
+  return counter;
+}
+
+int main(void)
+{
+  int sum;
+  sum = 0;
+  // limit is never stored, so loads of it fold to 0
+  if (limit == 0) {
+    sum = square(3) + step();
+  }
+  exported = sum;
+  return sum - 10;
+}
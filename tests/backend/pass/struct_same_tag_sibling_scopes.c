@@ -0,0 +1,15 @@
+int f(void) {
+  struct S {int x; int y;} s;
+  s.y = 2;
+  return s.y;
+}
+
+int g(void) {
+  struct S {char c;} s;
+  s.c = 40;
+  return s.c;
+}
+
+int main(void) {
+  return f() + g();
+}
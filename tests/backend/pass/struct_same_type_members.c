@@ -0,0 +1,10 @@
+int main(void) {
+  struct P {int x; int y; char c; int z;} p;
+  struct P *q;
+  q = &p;
+  p.x = 1;
+  p.y = 2;
+  q->c = 3;
+  q->z = 36;
+  return p.x + q->y + p.c + q->z;
+}
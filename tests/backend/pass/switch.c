@@ -0,0 +1,78 @@
+int classify(int state)
+{
+  int result;
+  result = 0;
+  switch (state) {
+    case 0:
+      result = 10;
+      break;
+    case 1:
+    case 2:
+      result = 20;
+      break;
+    case 'a':
+      result = 30;
+      // falls through
+    case 7:
+      result = result + 1;
+      break;
+    default:
+      result = -1;
+  }
+  return result;
+}
+
+int sparse(int x)
+{
+  switch (x) {
+    case 1000:
+      return 1;
+    case -5:
+      return 2;
+    case 1 + 2:
+      return 3;
+  }
+  return 0;
+}
+
+int loop(int n)
+{
+  int i;
+  int count;
+  i = 0;
+  count = 0;
+  while (i < n) {
+    switch (i) {
+      case 1:
+        i = i + 1;
+        continue;
+      default:
+        count = count + 1;
+    }
+    i = i + 1;
+  }
+  return count;
+}
+
+int dead(int x)
+{
+  return x;
+  // neither switch is emitted, only a goto label could reach them
+  switch (x) {
+    case 1:
+      x = 2;
+  }
+  switch (x) {
+    default:
+      switch (x) {
+        case 3:
+          x = 4;
+      }
+  }
+}
+
+int main(void)
+{
+  return classify(0) + classify(2) + classify('a') + classify(7) + classify(9)
+    + sparse(3) + loop(4) + dead(1) - 68;
+}
@@ -0,0 +1,48 @@
+struct point {
+  int x;
+  int y;
+  char tag;
+  struct point *next;
+};
+
+int sum(int *p, char *c, int n)
+{
+  int s;
+  int i;
+  s = 0;
+  i = 0;
+  while (i < n) {
+    *c = 1;
+    s = s + p[i];
+    i = i + 1;
+  }
+  return s;
+}
+
+int walk(struct point *p)
+{
+  int s;
+  s = 0;
+  while (p != 0) {
+    p->tag = 'x';
+    s = s + p->x + p->y;
+    p = p->next;
+  }
+  return s;
+}
+
+int main(void)
+{
+  struct point a;
+  struct point b;
+  int v;
+  char c;
+  a.x = 1;
+  a.y = 2;
+  a.next = &b;
+  b.x = 3;
+  b.y = 4;
+  b.next = 0;
+  v = 6;
+  return walk(&a) + sum(&v, &c, 1) - 16;
+}
@@ -0,0 +1,38 @@
+int sign(int x)
+{
+  if (x < 0)
+    return -1;
+  else
+    return 1;
+}
+
+int skip(int n)
+{
+  int i;
+  i = 0;
+  goto test;
+  while (1) {
+    i = i + 1;
+test:
+    if (!(i < n))
+      break;
+    continue;
+    i = 42;
+  }
+  return i;
+  i = 0;
+}
+
+int once(int n)
+{
+  do {
+    n = n + 1;
+    break;
+  } while (n);
+  return n;
+}
+
+int main(void)
+{
+  return sign(-3) + skip(4) + once(1) - 5;
+}
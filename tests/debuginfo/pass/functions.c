@@ -0,0 +1,18 @@
+int twice(int x)
+{
+  return x + x;
+}
+
+static int unused(void)
+{
+  return 0;
+}
+
+int main(void)
+{
+  int i;
+  i = twice(2);
+  while (0 < i)
+    i = i - 1;
+  return i;
+}
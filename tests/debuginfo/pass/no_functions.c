@@ -0,0 +1,11 @@
+// the compile unit is emitted even though no function describes the file
+struct list {
+  int value;
+  struct list *next;
+};
+
+struct list head;
+int count;
+char *name;
+
+int length(struct list *l);
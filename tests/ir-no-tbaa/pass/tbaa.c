@@ -0,0 +1,21 @@
+// --no-tbaa leaves out the access tags and the type nodes
+// CHECK-NOT: !tbaa
+// CHECK-NOT: TBAA
+struct point {
+  int x;
+  char tag;
+  struct point *next;
+};
+
+int walk(struct point *p, int *count)
+{
+  int s;
+  s = 0;
+  while (p != 0) {
+    p->tag = 120;
+    s = s + p->x;
+    *count = *count + 1;
+    p = p->next;
+  }
+  return s;
+}
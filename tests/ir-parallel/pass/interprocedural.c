@@ -0,0 +1,29 @@
+// the inliner and GlobalOpt see the whole module before it is split into
+// partitions: scale is inlined into both callers and removed, and unused is
+// only ever stored with its initializer, so its loads are folded
+// CHECK: define i32 @twice\(
+// CHECK: define i32 @thrice\(
+// CHECK-NOT: @scale
+// CHECK-NOT: @unused
+static int unused;
+
+static int scale(int x, int factor)
+{
+  unused = 0;
+  return x * factor + unused;
+}
+
+int twice(int x)
+{
+  return scale(x, 2);
+}
+
+int thrice(int x)
+{
+  return scale(x, 3);
+}
+
+int main(void)
+{
+  return twice(3) + thrice(2) - 12;
+}
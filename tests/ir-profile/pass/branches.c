@@ -0,0 +1,15 @@
+// the counts of branches.profile for count in branches.c are summed over its
+// two sections, the ones of count in other.c belong to another module
+// CHECK: metadata !"branch_weights", i32 4, i32 2\}
+// CHECK: metadata !"branch_weights", i32 28, i32 4\}
+// CHECK-NOT: i32 1004
+int count(int n)
+{
+  int i;
+  int odd;
+  odd = 0;
+  for (i = 0; i < n; i = i + 1)
+    if (i == 2 * odd + 1)
+      odd = odd + 1;
+  return odd;
+}
@@ -0,0 +1,10 @@
+// the value of && is merged from the blocks of its two outcomes, so the
+// load through p is only reached if p is not null
+// CHECK: phi i32 \[ 1, %[-.a-z0-9]+ \], \[ 0, %[-.a-z0-9]+ \]
+// CHECK-NOT: = and i1
+int guarded(int *p)
+{
+  int x;
+  x = p && *p;
+  return x;
+}
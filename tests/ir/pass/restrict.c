@@ -0,0 +1,19 @@
+// restrict qualified pointer parameters are noalias arguments, a pointer to
+// a restrict qualified pointer is not
+// CHECK: define i32 @add\(i32\* noalias[^,]*, i32\* noalias[^,]*, i32
+// CHECK-NOT: @first\(i32\*\* noalias
+int add(int * restrict dst, int *restrict src, int n)
+{
+  int i;
+  i = 0;
+  while (i < n) {
+    dst[i] = dst[i] + src[i];
+    i = i + 1;
+  }
+  return dst[0];
+}
+
+int first(int * restrict * p)
+{
+  return **p;
+}
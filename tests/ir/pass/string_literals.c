@@ -0,0 +1,19 @@
+// each distinct string is one private, unnamed_addr constant, however often
+// it occurs
+// CHECK: ^@\.str[0-9]* = private unnamed_addr constant \[6 x i8\] c"hello\\00"
+// CHECK: ^@\.str[0-9]* = private unnamed_addr constant \[7 x i8\] c"hello\\0A\\00"
+// CHECK-NOT: c"hello\\00"[\s\S]*c"hello\\00"
+char *greeting(void)
+{
+  return "hello";
+}
+
+char *again(void)
+{
+  return "hello";
+}
+
+char *line(void)
+{
+  return "hello\n";
+}
@@ -0,0 +1,14 @@
+// the struct layouts are the ones of the host, so the long member is
+// aligned to 8 bytes, which the offsets in the TBAA struct node show
+// CHECK: ^target datalayout = "
+// CHECK: metadata !"mixed", metadata ![0-9]+, i64 0, metadata ![0-9]+, i64 8, metadata ![0-9]+, i64 16\}
+struct mixed {
+  int small;
+  long big;
+  char tag;
+};
+
+long big(struct mixed *m)
+{
+  return m->big;
+}
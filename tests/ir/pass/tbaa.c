@@ -0,0 +1,22 @@
+// the loads and stores through pointers carry their access tags
+// CHECK: store i8 120, i8\* .*, !tbaa ![0-9]+
+// CHECK: load i32\* .*, !tbaa ![0-9]+
+// CHECK: metadata !"Simple C/C\+\+ TBAA"
+struct point {
+  int x;
+  char tag;
+  struct point *next;
+};
+
+int walk(struct point *p, int *count)
+{
+  int s;
+  s = 0;
+  while (p != 0) {
+    p->tag = 120;
+    s = s + p->x;
+    *count = *count + 1;
+    p = p->next;
+  }
+  return s;
+}
@@ -0,0 +1,8 @@
+// both arms are cheap and free of side effects, so they are evaluated
+// unconditionally and a select picks one of them instead of a branch
+// CHECK: = select i1 
+// CHECK-NOT: ternary-consequence
+int min(int a, int b)
+{
+  return a < b ? a : b;
+}
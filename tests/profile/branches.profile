@@ -0,0 +1,9 @@
+c4-profile 2
+branches.c count 0 2 0
+branches.c count 1 10 10
+branches.c count 2 18 2
+other.c count 0 1000 0
+c4-profile 2
+branches.c count 0 1 1
+branches.c count 1 5 5
+branches.c count 2 9 1
@@ -0,0 +1,12 @@
+// the profile writer would call this function instead of the C library's
+char *fopen(char *name, char *mode)
+{
+  return name;
+}
+
+int main(void)
+{
+  if (fopen("c4.profile", "a"))
+    return 0;
+  return 1;
+}
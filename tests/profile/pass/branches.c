@@ -0,0 +1,22 @@
+/*
+ * branches.profile has two sections with counts for count, as if two
+ * modules had appended them; main is not in the profile, so its branch gets
+ * no weights
+ */
+int count(int n)
+{
+  int i;
+  int odd;
+  odd = 0;
+  for (i = 0; i < n; i = i + 1)
+    if (i == 2 * odd + 1)
+      odd = odd + 1;
+  return odd;
+}
+
+int main(void)
+{
+  if (count(10) != 5)
+    return 1;
+  return count(0);
+}
@@ -0,0 +1,37 @@
+/*
+ * SCCP only tracks integers of up to 32 bits; wider ones are overdefined,
+ * even if they are constant, and so is everything computed from them
+ */
+long twice(long x)
+{
+  return x + x;
+}
+
+int main(void)
+{
+  long big;
+  long copy;
+  unsigned int u;
+  int small;
+  int result;
+  result = 0;
+  big = 4294967296;
+  copy = big;
+  if (copy + copy != 8589934592)
+    result = result + 1;
+  if (twice(big) != 8589934592)
+    result = result + 1;
+  // truncated to a tracked type again
+  small = big + 7;
+  if (small != 7)
+    result = result + 1;
+  // unsigned comparisons of tracked constants are not folded
+  u = 0;
+  u = u - 1;
+  if (u < 1)
+    result = result + 1;
+  small = -1;
+  if (!(small < 0) || !(u == small))
+    result = result + 1;
+  return result;
+}
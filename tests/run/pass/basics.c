@@ -0,0 +1,44 @@
+int abs(int x);
+
+struct point {
+  int x;
+  int y;
+};
+
+int fac(int n)
+{
+  if (n < 2)
+    return 1;
+  return n * fac(n - 1);
+}
+
+int length(char *s)
+{
+  int n;
+  n = 0;
+  while (s[n])
+    n = n + 1;
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  struct point p;
+  struct point *q;
+  int n;
+  int result;
+  result = 0;
+  if (fac(5) != 120)
+    result = result + 1;
+  p.x = 3;
+  q = &p;
+  // declared only, the JIT finds it in the C library
+  q->y = abs(-4);
+  if (p.x * p.x + p.y * p.y != 25)
+    result = result + 1;
+  // the file is argv[0], there are no further arguments
+  n = length(argv[0]);
+  if (argc != 1 || argv[0][n - 2] != '.' || argv[0][n - 1] != 'c')
+    result = result + 1;
+  return result;
+}
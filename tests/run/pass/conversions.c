@@ -0,0 +1,47 @@
+int main(void)
+{
+  int i;
+  int minus;
+  char c;
+  unsigned int u;
+  long big;
+  unsigned long size;
+  int result;
+  result = 0;
+  minus = -1;
+  // int to long keeps the sign
+  big = minus;
+  if (big != -1 || big + 4294967296 != 4294967295)
+    result = result + 1;
+  // unsigned int to long does not
+  u = 0;
+  u = u - 1;
+  big = u;
+  if (big != 4294967295)
+    result = result + 1;
+  // long to int keeps the lower 32 bits
+  big = 4294967298;
+  i = big;
+  if (i != 2)
+    result = result + 1;
+  // int and unsigned int compare as unsigned int
+  if (minus < u || !(u == minus))
+    result = result + 1;
+  // unsigned long and int compare as unsigned long
+  size = 1;
+  if (!(size < minus))
+    result = result + 1;
+  // long and unsigned int compare as long, which holds all unsigned ints
+  big = minus;
+  if (u < big)
+    result = result + 1;
+  // unsigned arithmetic wraps around
+  u = 4000000000;
+  if (u + u != 3705032704)
+    result = result + 1;
+  c = 'a';
+  big = c;
+  if (big * 100000000 != 9700000000)
+    result = result + 1;
+  return result;
+}
@@ -0,0 +1,56 @@
+int counter;
+char *greeting;
+
+struct pair {
+  int first;
+  int second;
+};
+
+struct pair totals;
+
+void count(int n)
+{
+  while (n) {
+    counter = counter + 1;
+    n = n - 1;
+  }
+}
+
+int length(char *begin, char *end)
+{
+  int n;
+  n = 0;
+  while (begin < end) {
+    n = n + 1;
+    begin = begin + 1;
+  }
+  return n;
+}
+
+int main(void)
+{
+  int i;
+  int result;
+  result = 0;
+  // globals start as zero
+  if (counter != 0 || totals.second != 0 || greeting != 0)
+    result = result + 1;
+  count(7);
+  count(3);
+  if (counter != 10)
+    result = result + 1;
+  i = 0;
+  do {
+    totals.first = totals.first + i;
+    totals.second = totals.second + i * i;
+    i = i + 1;
+  } while (i < 4);
+  if (totals.first != 6 || totals.second != 14)
+    result = result + 1;
+  greeting = "hello";
+  if (greeting[1] != 'e' || *(greeting + 4) != 'o')
+    result = result + 1;
+  if (length(greeting, greeting + 5) != 5)
+    result = result + 1;
+  return result;
+}
@@ -0,0 +1,36 @@
+// the operands are parameters, so the front end cannot fold the operators
+int check(int two, int four, long big, char *s)
+{
+  int result;
+  result = 0;
+  // !, && and || yield 0 or 1, not the bitwise results -3, 0 and 6
+  if (!two + (two && four) - 1 != 0)
+    result = result + 1;
+  if ((two || four) != 1)
+    result = result + 1;
+  if ((two && !four) != 0)
+    result = result + 1;
+  if (!!four != 1)
+    result = result + 1;
+  // only the upper bits of big are set
+  if (!big != 0 || (big && two) != 1)
+    result = result + 1;
+  if (!s != 0 || (s || 0) != 1)
+    result = result + 1;
+  return result;
+}
+
+// as values, && and || short circuit as well: p is null, *p is never read
+int guarded(int *p, int *q)
+{
+  int x;
+  x = p && *p;
+  return x + (q || *p);
+}
+
+int main(void)
+{
+  int one;
+  one = 1;
+  return check(2, 4, 4294967296, "x") + guarded(0, &one) - 1;
+}
@@ -0,0 +1,74 @@
+int sum(int n)
+{
+  int i;
+  int total;
+  total = 0;
+  for (i = 0; i < n; i = i + 1) {
+    if (i == 3)
+      continue;
+    total = total + i;
+  }
+  return total;
+}
+
+// the test after the body branches back from several blocks
+int either(int n)
+{
+  int i;
+  int j;
+  int count;
+  i = 0;
+  j = 10;
+  count = 0;
+  while (i < n || 5 < j) {
+    i = i + 1;
+    j = j - 1;
+    count = count + 1;
+  }
+  return count;
+}
+
+int both(int n)
+{
+  int i;
+  int count;
+  count = 0;
+  for (i = 0; i < n && count < 3; i = i + 1)
+    count = count + 1;
+  return count;
+}
+
+int rounds(int n)
+{
+  int count;
+  count = 0;
+  do {
+    count = count + 1;
+    n = n - 1;
+  } while (n == 2 || !(n < 4));
+  return count;
+}
+
+int main(void)
+{
+  int result;
+  result = 0;
+  if (sum(6) != 12)
+    result = result + 1;
+  if (either(2) != 5)
+    result = result + 1;
+  if (either(7) != 7)
+    result = result + 1;
+  if (both(2) != 2)
+    result = result + 1;
+  if (both(9) != 3)
+    result = result + 1;
+  // repeats while n is 6, 5 or 4 after the decrement
+  if (rounds(7) != 4)
+    result = result + 1;
+  if (rounds(3) != 2)
+    result = result + 1;
+  if (rounds(0) != 1)
+    result = result + 1;
+  return result;
+}
@@ -0,0 +1,42 @@
+/*
+ * With --parallel-opt, the functions end up in different partitions, which
+ * refer to each other's static functions and variables by name
+ */
+static int counter;
+int total;
+static char *greeting;
+
+static int bump(int n)
+{
+  counter = counter + n;
+  return counter;
+}
+
+static int twice(int n)
+{
+  return bump(n) + bump(n);
+}
+
+int apply(int (*f)(int), int n)
+{
+  return f(n);
+}
+
+int length(char *s)
+{
+  int n;
+  n = 0;
+  while (s[n])
+    n = n + 1;
+  return n;
+}
+
+int main(void)
+{
+  greeting = "hello";
+  total = apply(twice, 1) + apply(bump, 2);
+  // 1 + 2 for twice, 4 for bump
+  if (total != 7 || counter != 4)
+    return 1;
+  return length(greeting) - 5;
+}
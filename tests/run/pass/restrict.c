@@ -0,0 +1,27 @@
+int add(int * restrict dst, int *restrict src, int n)
+{
+  int i;
+  i = 0;
+  while (i < n) {
+    dst[i] = dst[i] + src[i];
+    i = i + 1;
+  }
+  return dst[0];
+}
+
+// p itself is not restrict qualified, only the pointer it points to
+int first(int * restrict * p)
+{
+  return **p;
+}
+
+int main(void)
+{
+  int a;
+  int b;
+  int *pa;
+  a = 1;
+  b = 2;
+  pa = &a;
+  return add(&a, &b, 1) + first(&pa) - 6;
+}
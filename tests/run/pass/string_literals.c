@@ -0,0 +1,18 @@
+char *greeting(void)
+{
+  return "hello";
+}
+
+char *again(void)
+{
+  return "hello";
+}
+
+int main(void)
+{
+  char *a;
+  char *b;
+  a = "hello";
+  b = "hello\n";
+  return (a[1] == greeting()[1]) + (again()[4] == b[4]) + (b[5] == 10) - 3;
+}
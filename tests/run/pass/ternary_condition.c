@@ -0,0 +1,26 @@
+int counter;
+
+int bump(void)
+{
+  counter = counter + 1;
+  return counter;
+}
+
+int main(void)
+{
+  int *p;
+  int zero;
+  int result;
+  p = 0;
+  zero = 0;
+  result = 0;
+  // the arms are cheap enough for a select, but the conditions have to
+  // short circuit: *p is not evaluated, and neither is bump()
+  if (((p && *p) ? 1 : 2) != 2)
+    result = result + 1;
+  if (((zero && bump()) ? 1 : 2) != 2)
+    result = result + 1;
+  if (((!zero || bump()) ? 1 : 2) != 1)
+    result = result + 1;
+  return result + counter;
+}
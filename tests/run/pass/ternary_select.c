@@ -0,0 +1,26 @@
+int min(int a, int b)
+{
+  return a < b ? a : b;
+}
+
+char *pick(int c, char *p, char *q)
+{
+  return c ? p : q;
+}
+
+int counter;
+
+int bump(void)
+{
+  counter = counter + 1;
+  return counter;
+}
+
+int main(void)
+{
+  int x;
+  x = 3;
+  // calls have side effects, so only one of them may be evaluated
+  x = x == 3 ? bump() : bump() + 10;
+  return min(x, -x + 2) + (pick(1, "a", 0) == 0) + counter - 2;
+}
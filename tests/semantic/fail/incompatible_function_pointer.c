@@ -0,0 +1,8 @@
+int f(int a, char b);
+int g(int a, int b);
+int main(void) {
+  int (*p)(int, int);
+  p = g;
+  p = f;
+  return 0;
+}
@@ -0,0 +1,7 @@
+// the first declaration gives f external linkage, static cannot change it
+int f(void);
+
+static int f(void)
+{
+  return 1;
+}
@@ -0,0 +1,7 @@
+// a static function which is used has to be defined in the same file
+static int f(int);
+
+int g(void)
+{
+  return f(1);
+}
@@ -0,0 +1,12 @@
+struct s;
+
+// s is still incomplete here, also when the body is checked in parallel
+// after s has been completed
+int first(struct s *p)
+{
+  return p->x;
+}
+
+struct s {
+  int x;
+};
@@ -0,0 +1,11 @@
+int main(void) {
+  {
+    int y;
+    y = 1;
+  }
+  {
+    int z;
+    z = 2;
+  }
+  return y;
+}
@@ -0,0 +1,21 @@
+int x;
+char *p;
+
+int main(void) {
+  {
+    char x;
+    x = 'a';
+    {
+      int *x;
+      x = 0;
+    }
+    x = 'b';
+  }
+  {
+    int *p;
+    p = &x;
+  }
+  p = "outer p is visible again";
+  x = 1;
+  return x;
+}
@@ -0,0 +1,13 @@
+// a declaration without static keeps the internal linkage of the first one,
+// and unused is never defined, which is fine as long as nothing calls it
+static int f(int);
+int f(int x);
+int f(int x)
+{
+  return x;
+}
+static int unused(void);
+int g(void)
+{
+  return f(1);
+}